@@ -0,0 +1,114 @@
+/*
+memfuncs.c:
+    Memory functions shared by the ARM9 payload and the sysmodules, see their Makefiles
+
+Boyer-Moore Horspool algorithm adapted from http://www-igm.univ-mlv.fr/~lecroq/string/node18.html#SECTION00180
+memcpy, memset32 and memcmp adapted from https://github.com/mid-kid/CakesForeveryWan/blob/557a8e8605ab3ee173af6497486e8f22c261d0e2/source/memfuncs.c
+
+This is part of Luma3DS, this directory is licensed under the MIT license (see LICENSE for details), so that the
+MIT-licensed sysmodules can use it. It must not depend on the headers of any of them.
+*/
+
+#include "memfuncs.h"
+
+void memcpy(void *dest, const void *src, uint32_t size)
+{
+    uint8_t *destc = (uint8_t *)dest;
+    const uint8_t *srcc = (const uint8_t *)src;
+
+    //Word copies are only possible when both buffers share the same alignment
+    if((((uint32_t)destc ^ (uint32_t)srcc) & 3) == 0)
+    {
+        for(; ((uint32_t)destc & 3) != 0 && size != 0; size--)
+            *destc++ = *srcc++;
+
+        uint32_t *dest32 = (uint32_t *)destc;
+        const uint32_t *src32 = (const uint32_t *)srcc;
+
+        //32-byte bursts, these get compiled to ldm/stm pairs
+        for(; size >= 32; size -= 32, dest32 += 8, src32 += 8)
+        {
+            uint32_t w0 = src32[0], w1 = src32[1], w2 = src32[2], w3 = src32[3],
+                     w4 = src32[4], w5 = src32[5], w6 = src32[6], w7 = src32[7];
+
+            dest32[0] = w0; dest32[1] = w1; dest32[2] = w2; dest32[3] = w3;
+            dest32[4] = w4; dest32[5] = w5; dest32[6] = w6; dest32[7] = w7;
+        }
+
+        for(; size >= 4; size -= 4)
+            *dest32++ = *src32++;
+
+        destc = (uint8_t *)dest32;
+        srcc = (const uint8_t *)src32;
+    }
+
+    for(; size != 0; size--)
+        *destc++ = *srcc++;
+}
+
+void memset32(void *dest, uint32_t filler, uint32_t size)
+{
+    uint32_t *dest32 = (uint32_t *)dest;
+
+    for(uint32_t i = 0; i < size / 4; i++)
+        dest32[i] = filler;
+}
+
+int memcmp(const void *buf1, const void *buf2, uint32_t size)
+{
+    const uint8_t *buf1c = (const uint8_t *)buf1,
+                  *buf2c = (const uint8_t *)buf2;
+
+    if((((uint32_t)buf1c ^ (uint32_t)buf2c) & 3) == 0)
+    {
+        for(; ((uint32_t)buf1c & 3) != 0 && size != 0; size--, buf1c++, buf2c++)
+        {
+            int cmp = *buf1c - *buf2c;
+            if(cmp != 0) return cmp;
+        }
+
+        //Skip over equal words, the differing one (if any) is handled by the byte loop below
+        const uint32_t *buf1w = (const uint32_t *)buf1c,
+                        *buf2w = (const uint32_t *)buf2c;
+
+        for(; size >= 4 && *buf1w == *buf2w; size -= 4, buf1w++, buf2w++);
+
+        buf1c = (const uint8_t *)buf1w;
+        buf2c = (const uint8_t *)buf2w;
+    }
+
+    for(; size != 0; size--, buf1c++, buf2c++)
+    {
+        int cmp = *buf1c - *buf2c;
+        if(cmp != 0) return cmp;
+    }
+
+    return 0;
+}
+
+uint8_t *memsearch(uint8_t *startPos, const void *pattern, uint32_t size, uint32_t patternSize)
+{
+    const uint8_t *patternc = (const uint8_t *)pattern;
+    uint32_t table[256];
+
+    //Preprocessing
+    for(uint32_t i = 0; i < 256; i++)
+        table[i] = patternSize;
+    for(uint32_t i = 0; i < patternSize - 1; i++)
+        table[patternc[i]] = patternSize - i - 1;
+
+    //Searching
+    uint8_t first = patternc[0],
+            last = patternc[patternSize - 1];
+    uint32_t j = 0;
+    while(j <= size - patternSize)
+    {
+        //Last byte first, then the first byte, before comparing what is in between
+        uint8_t c = startPos[j + patternSize - 1];
+        if(last == c && first == startPos[j] && (patternSize <= 2 || memcmp(patternc + 1, startPos + j + 1, patternSize - 2) == 0))
+            return startPos + j;
+        j += table[c];
+    }
+
+    return NULL;
+}
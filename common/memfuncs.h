@@ -0,0 +1,16 @@
+/*
+memfuncs.h:
+    Memory functions shared by the ARM9 payload and the sysmodules
+
+This is part of Luma3DS, this directory is licensed under the MIT license (see LICENSE for details).
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+void memcpy(void *dest, const void *src, uint32_t size);
+void memset32(void *dest, uint32_t filler, uint32_t size);
+int memcmp(const void *buf1, const void *buf2, uint32_t size);
+uint8_t *memsearch(uint8_t *startPos, const void *pattern, uint32_t size, uint32_t patternSize);
@@ -57,6 +57,7 @@ extern Result (*ControlMemory)(u32 *addrOut, u32 addr0, u32 addr1, u32 size, Mem
 extern void (*SleepThread)(s64 ns);
 extern Result (*CloseHandle)(Handle handle);
 extern Result (*GetHandleInfo)(s64 *out, Handle handle, u32 type);
+extern u64 (*GetSystemTick)(void);
 extern Result (*GetSystemInfo)(s64 *out, s32 type, s32 param);
 extern Result (*GetProcessInfo)(s64 *out, Handle processHandle, u32 type);
 extern Result (*GetThreadInfo)(s64 *out, Handle threadHandle, u32 type);
@@ -32,6 +32,7 @@
 #include "utils.h"
 
 #define MAX_SESSION     345
+#define SESSION_INDEX_SIZE  0x200
 
 // the structure of sessions is apparently not the same on older versions...
 
@@ -39,8 +40,22 @@ typedef struct SessionInfo
 {
     KSession *session;
     char name[12];
+    u16 prevSameName, nextSameName; // 1-based slot indices, 0 = none. nextSameName also links free slots
+
+    // Forwarded requests, only counted while ipcStatsEnabled is set
+    u32 nbRequests;
+    u32 maxTicks;
+    u64 totalTicks;
 } SessionInfo;
 
+typedef struct ServiceIpcStats
+{
+    char name[8];
+    u32 nbRequests;
+    u32 maxTicks;
+    u64 totalTicks;
+} ServiceIpcStats;
+
 typedef struct LangemuAttributes
 {
     u64 titleId;
@@ -50,11 +65,18 @@ typedef struct LangemuAttributes
 extern KRecursiveLock processLangemuLock;
 extern LangemuAttributes processLangemuAttributes[0x40];
 
+extern bool ipcStatsEnabled;
+
 SessionInfo *SessionInfo_Lookup(KSession *session);
 SessionInfo *SessionInfo_FindFirst(const char *name);
-void SessionInfo_ChangeVtable(KSession *session);
+void SessionInfo_ChangeVtable(KSession *session, bool hooked);
+bool SessionInfo_IsHooked(KSession *session);
+bool SessionInfo_IsHookedServiceName(const char *name);
 void SessionInfo_Add(KSession *session, const char *name);
 void SessionInfo_Remove(KSession *session);
+void SessionInfo_RecordRequest(KSession *session, u32 ticks);
+void SessionInfo_ResetStats(void);
+bool SessionInfo_GetServiceStats(ServiceIpcStats *out, u32 nameSlot);
 
 bool doLangEmu(Result *res, u32 *cmdbuf);
 Result doPublishToProcessHook(Handle handle, u32 *cmdbuf);
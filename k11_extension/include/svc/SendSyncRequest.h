@@ -30,4 +30,6 @@
 #include "kernel.h"
 #include "svc.h"
 
+extern u32 sendSyncRequestHookHits[4], sendSyncRequestHookMisses[4];
+
 Result SendSyncRequestHook(Handle handle);
@@ -27,37 +27,93 @@
 #include "ipc.h"
 #include "memory.h"
 
+// Entries never move. They are indexed by session pointer and by name through two open-addressing hash tables
+// (linear probing) of 1-based slot indices; sessions with the same name are chained together
 static SessionInfo sessionInfos[MAX_SESSION] = { {NULL} };
-static u32 nbActiveSessions = 0;
+static u32 nbActiveSessions = 0, nbUsedSessionInfos = 0;
+static u16 freeSessionInfos = 0;
+static u16 sessionIndex[SESSION_INDEX_SIZE] = { 0 }, sessionNameIndex[SESSION_INDEX_SIZE] = { 0 };
 static KRecursiveLock sessionInfosLock = { NULL };
 
+bool ipcStatsEnabled = false;
+
 KRecursiveLock processLangemuLock;
 LangemuAttributes processLangemuAttributes[0x40];
 
 static void *customSessionVtable[0x10] = { NULL }; // should be enough
+static void *customHookedSessionVtable[0x10] = { NULL }; // same, but tags the sessions SendSyncRequestHook has to look at
+
+static u32 SessionInfo_HashSession(KSession *session)
+{
+    return (((u32)session >> 2) * 0x9E3779B1) >> 23;
+}
+
+static u32 SessionInfo_HashName(const char *name)
+{
+    u32 h = 0x811C9DC5; // FNV-1a
+    for(u32 i = 0; i < 12 && name[i] != 0; i++)
+        h = (h ^ (u8)name[i]) * 0x01000193;
+
+    return (h * 0x9E3779B1) >> 23;
+}
+
+static u32 SessionInfo_HashSessionEntry(const SessionInfo *info)
+{
+    return SessionInfo_HashSession(info->session);
+}
+
+static u32 SessionInfo_HashNameEntry(const SessionInfo *info)
+{
+    return SessionInfo_HashName(info->name);
+}
+
+// Both return the position of the entry if found, otherwise the free position where it would be inserted
+static u32 SessionInfo_FindSessionPos(KSession *session)
+{
+    u32 pos;
+    for(pos = SessionInfo_HashSession(session); sessionIndex[pos] != 0 && sessionInfos[sessionIndex[pos] - 1].session != session;
+        pos = (pos + 1) % SESSION_INDEX_SIZE);
+
+    return pos;
+}
 
-static u32 SessionInfo_FindClosestSlot(KSession *session)
+static u32 SessionInfo_FindNamePos(const char *name)
 {
-    if(nbActiveSessions == 0 || session <= sessionInfos[0].session)
-        return 0;
-    else if(session > sessionInfos[nbActiveSessions - 1].session)
-        return nbActiveSessions;
+    u32 pos;
+    for(pos = SessionInfo_HashName(name); sessionNameIndex[pos] != 0 && strncmp(sessionInfos[sessionNameIndex[pos] - 1].name, name, 12) != 0;
+        pos = (pos + 1) % SESSION_INDEX_SIZE);
 
-    u32 a = 0, b = nbActiveSessions - 1, m;
+    return pos;
+}
 
-    do
+static void SessionInfo_RemoveFromIndex(u16 *index, u32 pos, u32 (*hash)(const SessionInfo *))
+{
+    // Backward-shift deletion
+    u32 next = pos;
+    index[pos] = 0;
+    for(;;)
     {
-        m = (a + b) / 2;
-        if(sessionInfos[m].session < session)
-            a = m;
-        else if(sessionInfos[m].session > session)
-            b = m;
-        else
-            return m;
+        next = (next + 1) % SESSION_INDEX_SIZE;
+        if(index[next] == 0)
+            return;
+
+        u32 home = hash(&sessionInfos[index[next] - 1]);
+        if(pos <= next ? (home <= pos || home > next) : (home <= pos && home > next))
+        {
+            index[pos] = index[next];
+            index[next] = 0;
+            pos = next;
+        }
     }
-    while(b - a > 1);
+}
+
+static inline SessionInfo *SessionInfo_CheckVtable(SessionInfo *info)
+{
+    if(info == NULL)
+        return NULL;
 
-    return b;
+    void **vtable = (void **)info->session->autoObject.vtable;
+    return vtable == customSessionVtable || vtable == customHookedSessionVtable ? info : NULL;
 }
 
 SessionInfo *SessionInfo_Lookup(KSession *session)
@@ -65,12 +121,8 @@ SessionInfo *SessionInfo_Lookup(KSession *session)
     KRecursiveLock__Lock(criticalSectionLock);
     KRecursiveLock__Lock(&sessionInfosLock);
 
-    SessionInfo *ret;
-    u32 id = SessionInfo_FindClosestSlot(session);
-    if(id == nbActiveSessions)
-        ret = NULL;
-    else
-        ret = (void **)(sessionInfos[id].session->autoObject.vtable) == customSessionVtable ? &sessionInfos[id] : NULL;
+    u16 id = sessionIndex[SessionInfo_FindSessionPos(session)];
+    SessionInfo *ret = SessionInfo_CheckVtable(id == 0 ? NULL : &sessionInfos[id - 1]);
 
     KRecursiveLock__Unlock(&sessionInfosLock);
     KRecursiveLock__Unlock(criticalSectionLock);
@@ -83,13 +135,8 @@ SessionInfo *SessionInfo_FindFirst(const char *name)
     KRecursiveLock__Lock(criticalSectionLock);
     KRecursiveLock__Lock(&sessionInfosLock);
 
-    SessionInfo *ret;
-    u32 id;
-    for(id = 0; id < nbActiveSessions && strncmp(sessionInfos[id].name, name, 12) != 0; id++);
-    if(id == nbActiveSessions)
-        ret = NULL;
-    else
-        ret = (void **)(sessionInfos[id].session->autoObject.vtable) == customSessionVtable ? &sessionInfos[id] : NULL;
+    u16 id = sessionNameIndex[SessionInfo_FindNamePos(name)];
+    SessionInfo *ret = SessionInfo_CheckVtable(id == 0 ? NULL : &sessionInfos[id - 1]);
 
     KRecursiveLock__Unlock(&sessionInfosLock);
     KRecursiveLock__Unlock(criticalSectionLock);
@@ -100,35 +147,43 @@ SessionInfo *SessionInfo_FindFirst(const char *name)
 void SessionInfo_Add(KSession *session, const char *name)
 {
     KAutoObject__AddReference(&session->autoObject);
-    SessionInfo_ChangeVtable(session);
+    SessionInfo_ChangeVtable(session, SessionInfo_IsHookedServiceName(name));
     session->autoObject.vtable->DecrementReferenceCount(&session->autoObject);
 
     KRecursiveLock__Lock(criticalSectionLock);
     KRecursiveLock__Lock(&sessionInfosLock);
 
-    if(nbActiveSessions == MAX_SESSION)
+    u32 pos = SessionInfo_FindSessionPos(session);
+    if(nbActiveSessions == MAX_SESSION || sessionIndex[pos] != 0)
     {
         KRecursiveLock__Unlock(&sessionInfosLock);
         KRecursiveLock__Unlock(criticalSectionLock);
         return;
     }
 
-    u32 id = SessionInfo_FindClosestSlot(session);
-
-    if(id != nbActiveSessions && sessionInfos[id].session == session)
+    u16 id;
+    if(freeSessionInfos != 0)
     {
-        KRecursiveLock__Unlock(&sessionInfosLock);
-        KRecursiveLock__Unlock(criticalSectionLock);
-        return;
+        id = freeSessionInfos;
+        freeSessionInfos = sessionInfos[id - 1].nextSameName;
     }
+    else
+        id = ++nbUsedSessionInfos;
 
-    for(u32 i = nbActiveSessions; i > id && i != 0; i--)
-        sessionInfos[i] = sessionInfos[i - 1];
+    SessionInfo *info = &sessionInfos[id - 1];
+    info->session = session;
+    strncpy(info->name, name, 12);
+    sessionIndex[pos] = id;
 
-    nbActiveSessions++;
+    // Insert at the head of the list of sessions having this name
+    u32 namePos = SessionInfo_FindNamePos(info->name);
+    info->prevSameName = 0;
+    info->nextSameName = sessionNameIndex[namePos];
+    if(info->nextSameName != 0)
+        sessionInfos[info->nextSameName - 1].prevSameName = id;
+    sessionNameIndex[namePos] = id;
 
-    sessionInfos[id].session = session;
-    strncpy(sessionInfos[id].name, name, 12);
+    nbActiveSessions++;
 
     KRecursiveLock__Unlock(&sessionInfosLock);
     KRecursiveLock__Unlock(criticalSectionLock);
@@ -139,31 +194,116 @@ void SessionInfo_Remove(KSession *session)
     KRecursiveLock__Lock(criticalSectionLock);
     KRecursiveLock__Lock(&sessionInfosLock);
 
-    if(nbActiveSessions == MAX_SESSION)
+    u32 pos = SessionInfo_FindSessionPos(session);
+    u16 id = sessionIndex[pos];
+
+    if(id == 0)
     {
         KRecursiveLock__Unlock(&sessionInfosLock);
         KRecursiveLock__Unlock(criticalSectionLock);
         return;
     }
 
-    u32 id = SessionInfo_FindClosestSlot(session);
+    SessionInfo *info = &sessionInfos[id - 1];
+    SessionInfo_RemoveFromIndex(sessionIndex, pos, SessionInfo_HashSessionEntry);
 
-    if(id == nbActiveSessions)
+    if(info->prevSameName != 0)
+        sessionInfos[info->prevSameName - 1].nextSameName = info->nextSameName;
+    else
     {
-        KRecursiveLock__Unlock(&sessionInfosLock);
-        KRecursiveLock__Unlock(criticalSectionLock);
-        return;
+        u32 namePos = SessionInfo_FindNamePos(info->name);
+        if(info->nextSameName != 0)
+            sessionNameIndex[namePos] = info->nextSameName;
+        else
+            SessionInfo_RemoveFromIndex(sessionNameIndex, namePos, SessionInfo_HashNameEntry);
     }
 
-    for(u32 i = id; i < nbActiveSessions - 1; i++)
-        sessionInfos[i] = sessionInfos[i + 1];
+    if(info->nextSameName != 0)
+        sessionInfos[info->nextSameName - 1].prevSameName = info->prevSameName;
 
-    memset(&sessionInfos[--nbActiveSessions], 0, sizeof(SessionInfo));
+    // Keep the statistics of the service around as long as another session to it is open
+    u16 heirId = info->prevSameName != 0 ? info->prevSameName : info->nextSameName;
+    if(heirId != 0)
+    {
+        SessionInfo *heir = &sessionInfos[heirId - 1];
+        heir->nbRequests += info->nbRequests;
+        heir->totalTicks += info->totalTicks;
+        heir->maxTicks = info->maxTicks > heir->maxTicks ? info->maxTicks : heir->maxTicks;
+    }
+
+    memset(info, 0, sizeof(SessionInfo));
+    info->nextSameName = freeSessionInfos;
+    freeSessionInfos = id;
+    nbActiveSessions--;
 
     KRecursiveLock__Unlock(&sessionInfosLock);
     KRecursiveLock__Unlock(criticalSectionLock);
 }
 
+void SessionInfo_RecordRequest(KSession *session, u32 ticks)
+{
+    KRecursiveLock__Lock(criticalSectionLock);
+    KRecursiveLock__Lock(&sessionInfosLock);
+
+    u16 id = sessionIndex[SessionInfo_FindSessionPos(session)];
+    if(id != 0)
+    {
+        SessionInfo *info = &sessionInfos[id - 1];
+        info->nbRequests++;
+        info->totalTicks += ticks;
+        info->maxTicks = ticks > info->maxTicks ? ticks : info->maxTicks;
+    }
+
+    KRecursiveLock__Unlock(&sessionInfosLock);
+    KRecursiveLock__Unlock(criticalSectionLock);
+}
+
+void SessionInfo_ResetStats(void)
+{
+    KRecursiveLock__Lock(criticalSectionLock);
+    KRecursiveLock__Lock(&sessionInfosLock);
+
+    for(u32 i = 0; i < nbUsedSessionInfos; i++)
+    {
+        sessionInfos[i].nbRequests = 0;
+        sessionInfos[i].maxTicks = 0;
+        sessionInfos[i].totalTicks = 0;
+    }
+
+    KRecursiveLock__Unlock(&sessionInfosLock);
+    KRecursiveLock__Unlock(criticalSectionLock);
+}
+
+// Sums the statistics of all the sessions sharing the name stored in a given slot of the name index
+bool SessionInfo_GetServiceStats(ServiceIpcStats *out, u32 nameSlot)
+{
+    if(nameSlot >= SESSION_INDEX_SIZE)
+        return false;
+
+    KRecursiveLock__Lock(criticalSectionLock);
+    KRecursiveLock__Lock(&sessionInfosLock);
+
+    u16 id = sessionNameIndex[nameSlot];
+    bool found = id != 0;
+    if(found)
+    {
+        memset(out, 0, sizeof(ServiceIpcStats));
+        memcpy(out->name, sessionInfos[id - 1].name, 8);
+        for(; id != 0; id = sessionInfos[id - 1].nextSameName)
+        {
+            SessionInfo *info = &sessionInfos[id - 1];
+            out->nbRequests += info->nbRequests;
+            out->totalTicks += info->totalTicks;
+            out->maxTicks = info->maxTicks > out->maxTicks ? info->maxTicks : out->maxTicks;
+        }
+    }
+
+    KRecursiveLock__Unlock(&sessionInfosLock);
+    KRecursiveLock__Unlock(criticalSectionLock);
+
+    return found;
+}
+
 static void (*KSession__dtor_orig)(KAutoObject *this);
 static void KSession__dtor_hook(KAutoObject *this)
 {
@@ -171,15 +311,34 @@ static void KSession__dtor_hook(KAutoObject *this)
     SessionInfo_Remove((KSession *)this);
 }
 
-void SessionInfo_ChangeVtable(KSession *session)
+void SessionInfo_ChangeVtable(KSession *session, bool hooked)
 {
     if(customSessionVtable[2] == NULL)
     {
         memcpy(customSessionVtable, session->autoObject.vtable, 0x40);
         KSession__dtor_orig = session->autoObject.vtable->dtor;
         customSessionVtable[2] = (void *)KSession__dtor_hook;
+        memcpy(customHookedSessionVtable, customSessionVtable, 0x40);
     }
-    session->autoObject.vtable = (Vtable__KAutoObject *)customSessionVtable;
+    session->autoObject.vtable = (Vtable__KAutoObject *)(hooked ? customHookedSessionVtable : customSessionVtable);
+}
+
+bool SessionInfo_IsHooked(KSession *session)
+{
+    return (void **)session->autoObject.vtable == customHookedSessionVtable;
+}
+
+bool SessionInfo_IsHookedServiceName(const char *name)
+{
+    static const char *hookedServiceNames[] = { "srv:", "srv:pm", "err:f", "cfg:u", "cfg:s", "cfg:i", "ndm:u" };
+
+    for(u32 i = 0; i < sizeof(hookedServiceNames) / sizeof(hookedServiceNames[0]); i++)
+    {
+        if(strncmp(name, hookedServiceNames[i], 12) == 0)
+            return true;
+    }
+
+    return false;
 }
 
 bool doLangEmu(Result *res, u32 *cmdbuf)
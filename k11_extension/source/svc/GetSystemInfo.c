@@ -28,6 +28,8 @@
 #include "utils.h"
 #include "ipc.h"
 #include "synchronization.h"
+#include "svc/SendSyncRequest.h"
+#include "memory.h"
 
 Result GetSystemInfoHook(s64 *out, s32 type, s32 param)
 {
@@ -131,6 +133,62 @@ Result GetSystemInfoHook(s64 *out, s32 type, s32 param)
 
             break;
         }
+
+        case 0x10003: // SendSyncRequest hook statistics (summed over all cores)
+        {
+            u32 *counters;
+            switch(param)
+            {
+                case 0: // requests on sessions tagged as needing the hook
+                    counters = sendSyncRequestHookHits;
+                    break;
+                case 1: // requests forwarded without any lookup
+                    counters = sendSyncRequestHookMisses;
+                    break;
+                default:
+                    counters = NULL;
+                    res = 0xF8C007F4;
+                    break;
+            }
+
+            if(counters != NULL)
+            {
+                *out = 0;
+                for(u32 i = 0; i < getNumberOfCores(); i++)
+                    *out += counters[i];
+            }
+
+            break;
+        }
+
+        case 0x10004: // IPC statistics per service name, param = (slot of the name index << 2) | field
+        {
+            ServiceIpcStats stats;
+            if(param < 0 || !SessionInfo_GetServiceStats(&stats, (u32)param >> 2))
+            {
+                res = 0xD88007FA; // no service there
+                break;
+            }
+
+            switch(param & 3)
+            {
+                case 0:
+                    memcpy(out, stats.name, 8);
+                    break;
+                case 1:
+                    *out = stats.nbRequests;
+                    break;
+                case 2:
+                    *out = (s64)stats.totalTicks;
+                    break;
+                case 3:
+                    *out = stats.maxTicks;
+                    break;
+            }
+
+            break;
+        }
+
         default:
             GetSystemInfo(out, type, param);
             break;
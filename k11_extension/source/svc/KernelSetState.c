@@ -178,6 +178,14 @@ Result KernelSetStateHook(u32 type, u32 varg1, u32 varg2, u32 varg3)
             KRecursiveLock__Unlock(&dbgParamsLock);
             break;
         }
+        case 0x10007:
+        {
+            // bit0: enable IPC statistics, bit1: reset them
+            if(varg1 & 2)
+                SessionInfo_ResetStats();
+            ipcStatsEnabled = (varg1 & 1) != 0;
+            break;
+        }
         default:
         {
             res = KernelSetState(type, varg1, varg2, varg3);
@@ -28,6 +28,8 @@
 #include "memory.h"
 #include "ipc.h"
 
+u32 sendSyncRequestHookHits[4] = { 0 }, sendSyncRequestHookMisses[4] = { 0 }; // per core, no need for atomics
+
 Result SendSyncRequestHook(Handle handle)
 {
     KProcessHandleTable *handleTable = handleTableOfProcess(currentCoreContext->objectContext.currentProcess);
@@ -40,7 +42,17 @@ Result SendSyncRequestHook(Handle handle)
      // not the exact same test but it should work
     bool isValidClientSession = clientSession != NULL && strcmp(classNameOfAutoObject(&clientSession->syncObject.autoObject), "KClientSession") == 0;
 
+    // Only sessions to the services handled below are tagged, skip the lookups (and their locks) for everything else
+    bool isHookedSession = isValidClientSession && SessionInfo_IsHooked(clientSession->parentSession);
     if(isValidClientSession)
+    {
+        if(isHookedSession)
+            sendSyncRequestHookHits[getCurrentCoreID()]++;
+        else
+            sendSyncRequestHookMisses[getCurrentCoreID()]++;
+    }
+
+    if(isHookedSession)
     {
         switch (cmdbuf[0])
         {
@@ -222,10 +234,21 @@ Result SendSyncRequestHook(Handle handle)
         }
     }
 
+    // Our reference to the session is kept until the request has been recorded
+    bool isMeasured = !skip && isValidClientSession && ipcStatsEnabled;
+    if(isMeasured)
+    {
+        u64 startTick = GetSystemTick();
+        res = SendSyncRequest(handle);
+        u64 ticks = GetSystemTick() - startTick;
+        SessionInfo_RecordRequest(clientSession->parentSession, ticks > 0xFFFFFFFF ? 0xFFFFFFFF : (u32)ticks);
+    }
+
     if(clientSession != NULL)
         clientSession->syncObject.autoObject.vtable->DecrementReferenceCount(&clientSession->syncObject.autoObject);
 
-    res = skip ? res : SendSyncRequest(handle);
+    if(!isMeasured)
+        res = skip ? res : SendSyncRequest(handle);
 
     return res;
 }
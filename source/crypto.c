@@ -36,6 +36,7 @@
 #include "emunand.h"
 #include "strings.h"
 #include "utils.h"
+#include "cache.h"
 #include "fatfs/sdmmc/sdmmc.h"
 
 /****************************************************************
@@ -235,6 +236,53 @@ static void aes_batch(void *dst, const void *src, u32 blockCount)
     }
 }
 
+//NDMA can't reach the TCMs, and buffers must start on a cache line as they're flushed around transfers
+static inline bool aes_ndma_can_access(const void *ptr)
+{
+    return (u32)ptr >= 0x08000000 && (u32)ptr < 0x30000000 && ((u32)ptr & 0x1F) == 0;
+}
+
+//Starts a CTR mode transfer that runs in the background, the CPU is free until aes_ndma_wait
+static void aes_ctr_ndma_start(void *dst, const void *src, u32 blockCount, void *ctr, u32 ivMode)
+{
+    u32 size = blockCount * AES_BLOCK_SIZE;
+
+    flushDCacheRange((void *)src, size);
+    if(dst != src) flushDCacheRange(dst, size);
+
+    *REG_AESCNT =   AES_CTR_MODE |
+                    AES_CNT_INPUT_ORDER | AES_CNT_OUTPUT_ORDER |
+                    AES_CNT_INPUT_ENDIAN | AES_CNT_OUTPUT_ENDIAN |
+                    AES_CNT_FLUSH_READ | AES_CNT_FLUSH_WRITE |
+                    AES_CNT_WRFIFO_DMA_4 | AES_CNT_RDFIFO_DMA_4;
+    aes_setiv(ctr, ivMode);
+    aes_advctr(ctr, blockCount, ivMode);
+
+    *REG_NDMA_GLOBAL_CNT = NDMA_GLOBAL_ENABLE;
+
+    *REG_NDMA_SRC_ADDR(NDMA_AES_IN_CHANNEL) = (u32)src;
+    *REG_NDMA_DST_ADDR(NDMA_AES_IN_CHANNEL) = (u32)REG_AESWRFIFO;
+    *REG_NDMA_TRANSFER_CNT(NDMA_AES_IN_CHANNEL) = size / 4;
+    *REG_NDMA_WRITE_CNT(NDMA_AES_IN_CHANNEL) = 4;
+    *REG_NDMA_BLOCK_CNT(NDMA_AES_IN_CHANNEL) = 0;
+    *REG_NDMA_CNT(NDMA_AES_IN_CHANNEL) = NDMA_ENABLE | NDMA_STARTUP_AES_IN | NDMA_BURST_4_WORDS | NDMA_DST_UPDATE_FIXED;
+
+    *REG_NDMA_SRC_ADDR(NDMA_AES_OUT_CHANNEL) = (u32)REG_AESRDFIFO;
+    *REG_NDMA_DST_ADDR(NDMA_AES_OUT_CHANNEL) = (u32)dst;
+    *REG_NDMA_TRANSFER_CNT(NDMA_AES_OUT_CHANNEL) = size / 4;
+    *REG_NDMA_WRITE_CNT(NDMA_AES_OUT_CHANNEL) = 4;
+    *REG_NDMA_BLOCK_CNT(NDMA_AES_OUT_CHANNEL) = 0;
+    *REG_NDMA_CNT(NDMA_AES_OUT_CHANNEL) = NDMA_ENABLE | NDMA_STARTUP_AES_OUT | NDMA_BURST_4_WORDS | NDMA_SRC_UPDATE_FIXED;
+
+    *REG_AESBLKCNT = blockCount << 16;
+    *REG_AESCNT |= AES_CNT_START;
+}
+
+static void aes_ndma_wait(void)
+{
+    while(*REG_NDMA_CNT(NDMA_AES_OUT_CHANNEL) & NDMA_ENABLE);
+}
+
 static void aes(void *dst, const void *src, u32 blockCount, void *iv, u32 mode, u32 ivMode)
 {
     *REG_AESCNT =   mode |
@@ -283,11 +331,15 @@ static void sha_wait_idle()
     while(*REG_SHA_CNT & 1);
 }
 
-void sha(void *res, const void *src, u32 size, u32 mode)
+void sha_init(u32 mode)
 {
     sha_wait_idle();
     *REG_SHA_CNT = mode | SHA_CNT_OUTPUT_ENDIAN | SHA_NORMAL_ROUND;
+}
 
+//All but the last update of a hash must be a multiple of 0x40 bytes
+void sha_update(const void *src, u32 size)
+{
     const u32 *src32 = (const u32 *)src;
     int i;
     while(size >= 0x40)
@@ -306,7 +358,10 @@ void sha(void *res, const void *src, u32 size, u32 mode)
 
     sha_wait_idle();
     memcpy((void *)REG_SHA_INFIFO, src32, size);
+}
 
+void sha_get(void *res, u32 mode)
+{
     *REG_SHA_CNT = (*REG_SHA_CNT & ~SHA_NORMAL_ROUND) | SHA_FINAL_ROUND;
 
     while(*REG_SHA_CNT & SHA_FINAL_ROUND);
@@ -321,6 +376,13 @@ void sha(void *res, const void *src, u32 size, u32 mode)
     memcpy(res, (void *)REG_SHA_HASH, hashSize);
 }
 
+void sha(void *res, const void *src, u32 size, u32 mode)
+{
+    sha_init(mode);
+    sha_update(src, size);
+    sha_get(res, mode);
+}
+
 /*****************************************************************/
 
 __attribute__((aligned(4))) static u8 nandCtr[AES_BLOCK_SIZE];
@@ -349,11 +411,22 @@ int ctrNandInit(void)
 
     nandSlot = ISN3DS ? 0x05 : 0x04;
 
+    //The partition layout of a given NAND doesn't change, skip the reads when remounting it
+    static u32 cachedFatStartSource = 0xFFFFFFFF,
+               cachedFatStart;
+    u32 source = firmSource == FIRMWARE_SYSNAND ? 0 : emuHeader;
+
+    if(source == cachedFatStartSource)
+    {
+        fatStart = cachedFatStart;
+        return 0;
+    }
+
     int result;
     u8 __attribute__((aligned(4))) temp[0x200];
 
     //Read NCSD header
-    result = firmSource == FIRMWARE_SYSNAND ? sdmmc_nand_readsectors(0, 1, temp) : sdmmc_sdcard_readsectors(emuHeader, 1, temp);
+    result = firmSource == FIRMWARE_SYSNAND ? sdmmc_nand_readsectors(0, 1, temp) : readEmuNandHeader(temp);
 
     if(!result)
     {
@@ -362,61 +435,126 @@ int ctrNandInit(void)
 
         u32 ctrMbrOffset = *((u32 *)(temp + 0x120) + (2 * partitionNum));
 
-        //Read CTR MBR
+        //Read CTR MBR, its offset is absolute
+        fatStart = 0;
         result = ctrNandRead(ctrMbrOffset, 1, temp);
 
         //Calculate final CTRNAND FAT offset
-        if(!result) fatStart = ctrMbrOffset + *(u32 *)(temp + 0x1C6);
+        if(!result)
+        {
+            fatStart = ctrMbrOffset + *(u32 *)(temp + 0x1C6);
+            cachedFatStart = fatStart;
+            cachedFatStartSource = source;
+        }
     }
 
     return result;
 }
 
+static int ctrNandReadSectors(u32 sector, u32 sectorCount, u8 *outbuf)
+{
+    if(firmSource == FIRMWARE_SYSNAND)
+        return sdmmc_nand_readsectors(sector + fatStart, sectorCount, outbuf);
+
+    return sdmmc_sdcard_readsectors(sector + emuOffset + fatStart, sectorCount, outbuf);
+}
+
 int ctrNandRead(u32 sector, u32 sectorCount, u8 *outbuf)
 {
     __attribute__((aligned(4))) u8 tmpCtr[sizeof(nandCtr)];
     memcpy(tmpCtr, nandCtr, sizeof(nandCtr));
     aes_advctr(tmpCtr, ((sector + fatStart) * 0x200) / AES_BLOCK_SIZE, AES_INPUT_BE | AES_INPUT_NORMAL);
+    aes_use_keyslot(nandSlot);
 
-    //Read
-    int result;
-    if(firmSource == FIRMWARE_SYSNAND)
-        result = sdmmc_nand_readsectors(sector + fatStart, sectorCount, outbuf);
-    else
+    int result = 0;
+
+    if(!aes_ndma_can_access(outbuf))
     {
-        sector += emuOffset;
-        result = sdmmc_sdcard_readsectors(sector + fatStart, sectorCount, outbuf);
+        //Read
+        result = ctrNandReadSectors(sector, sectorCount, outbuf);
+
+        //Decrypt
+        aes(outbuf, outbuf, sectorCount * 0x200 / AES_BLOCK_SIZE, tmpCtr, AES_CTR_MODE, AES_INPUT_BE | AES_INPUT_NORMAL);
+
+        return result;
     }
 
-    //Decrypt
-    aes_use_keyslot(nandSlot);
-    aes(outbuf, outbuf, sectorCount * 0x200 / AES_BLOCK_SIZE, tmpCtr, AES_CTR_MODE, AES_INPUT_BE | AES_INPUT_NORMAL);
+    //Decrypt each chunk in the background while the next one is being read
+    bool isDecrypting = false;
+    for(u32 tempSector = 0; tempSector < sectorCount && !result; tempSector += CTRNAND_CHUNK_SECTORS)
+    {
+        u32 tempCount = CTRNAND_CHUNK_SECTORS < (sectorCount - tempSector) ? CTRNAND_CHUNK_SECTORS : (sectorCount - tempSector);
+        u8 *chunk = outbuf + tempSector * 0x200;
+
+        result = ctrNandReadSectors(sector + tempSector, tempCount, chunk);
+
+        if(isDecrypting) aes_ndma_wait();
+        isDecrypting = false;
+
+        if(!result)
+        {
+            aes_ctr_ndma_start(chunk, chunk, tempCount * 0x200 / AES_BLOCK_SIZE, tmpCtr, AES_INPUT_BE | AES_INPUT_NORMAL);
+            isDecrypting = true;
+        }
+    }
+
+    if(isDecrypting) aes_ndma_wait();
 
     return result;
 }
 
 int ctrNandWrite(u32 sector, u32 sectorCount, const u8 *inbuf)
 {
-    u8 *buffer = (u8 *)0xFFF00000;
-    u32 bufferSize = 0x4000;
-
     __attribute__((aligned(4))) u8 tmpCtr[sizeof(nandCtr)];
     memcpy(tmpCtr, nandCtr, sizeof(nandCtr));
     aes_advctr(tmpCtr, ((sector + fatStart) * 0x200) / AES_BLOCK_SIZE, AES_INPUT_BE | AES_INPUT_NORMAL);
     aes_use_keyslot(nandSlot);
 
     int result = 0;
-    for(u32 tempSector = 0; tempSector < sectorCount && !result; tempSector += bufferSize / 0x200)
+
+    if(!aes_ndma_can_access(inbuf))
     {
-        u32 tempCount = (bufferSize / 0x200) < (sectorCount - tempSector) ? (bufferSize / 0x200) : (sectorCount - tempSector);
+        u8 *buffer = (u8 *)0xFFF00000;
+        u32 bufferSize = 0x4000;
+
+        for(u32 tempSector = 0; tempSector < sectorCount && !result; tempSector += bufferSize / 0x200)
+        {
+            u32 tempCount = (bufferSize / 0x200) < (sectorCount - tempSector) ? (bufferSize / 0x200) : (sectorCount - tempSector);
 
-        memcpy(buffer, inbuf + (tempSector * 0x200), tempCount * 0x200);
+            memcpy(buffer, inbuf + (tempSector * 0x200), tempCount * 0x200);
 
-        //Encrypt
-        aes(buffer, buffer, tempCount * 0x200 / AES_BLOCK_SIZE, tmpCtr, AES_CTR_MODE, AES_INPUT_BE | AES_INPUT_NORMAL);
+            //Encrypt
+            aes(buffer, buffer, tempCount * 0x200 / AES_BLOCK_SIZE, tmpCtr, AES_CTR_MODE, AES_INPUT_BE | AES_INPUT_NORMAL);
+
+            //Write
+            result = sdmmc_nand_writesectors(tempSector + sector + fatStart, tempCount, buffer);
+        }
+
+        return result;
+    }
+
+    //Encrypt straight from the source into one buffer while the other one is being written
+    __attribute__((aligned(32))) static u8 buffers[2][CTRNAND_CHUNK_SECTORS * 0x200];
+
+    u32 firstCount = CTRNAND_CHUNK_SECTORS < sectorCount ? CTRNAND_CHUNK_SECTORS : sectorCount;
+    if(firstCount != 0)
+        aes_ctr_ndma_start(buffers[0], inbuf, firstCount * 0x200 / AES_BLOCK_SIZE, tmpCtr, AES_INPUT_BE | AES_INPUT_NORMAL);
+
+    for(u32 tempSector = 0, i = 0; tempSector < sectorCount; tempSector += CTRNAND_CHUNK_SECTORS, i ^= 1)
+    {
+        u32 tempCount = CTRNAND_CHUNK_SECTORS < (sectorCount - tempSector) ? CTRNAND_CHUNK_SECTORS : (sectorCount - tempSector),
+            nextSector = tempSector + tempCount;
+
+        aes_ndma_wait();
+        if(result) break;
+
+        if(nextSector < sectorCount)
+        {
+            u32 nextCount = CTRNAND_CHUNK_SECTORS < (sectorCount - nextSector) ? CTRNAND_CHUNK_SECTORS : (sectorCount - nextSector);
+            aes_ctr_ndma_start(buffers[i ^ 1], inbuf + nextSector * 0x200, nextCount * 0x200 / AES_BLOCK_SIZE, tmpCtr, AES_INPUT_BE | AES_INPUT_NORMAL);
+        }
 
-        //Write
-        result = sdmmc_nand_writesectors(tempSector + sector + fatStart, tempCount, buffer);
+        result = sdmmc_nand_writesectors(tempSector + sector + fatStart, tempCount, buffers[i]);
     }
 
     return result;
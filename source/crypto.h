@@ -67,6 +67,8 @@
 #define AES_CNT_OUTPUT_ENDIAN   0x00400000
 #define AES_CNT_FLUSH_READ      0x00000800
 #define AES_CNT_FLUSH_WRITE     0x00000400
+#define AES_CNT_WRFIFO_DMA_4    0x00003000 //Request input when 4 words are free
+#define AES_CNT_RDFIFO_DMA_4    0x00000000 //Request output when 4 words are available
 
 #define AES_INPUT_BE            (AES_CNT_INPUT_ENDIAN)
 #define AES_INPUT_LE            0
@@ -77,11 +79,34 @@
 
 #define AES_BLOCK_SIZE      0x10
 
+#define CTRNAND_CHUNK_SECTORS   0x20
+
 #define AES_KEYCNT_WRITE    (1 << 0x7)
 #define AES_KEYNORMAL       0
 #define AES_KEYX        1
 #define AES_KEYY        2
 
+/**************************NDMA****************************/
+#define REG_NDMA_GLOBAL_CNT         ((vu32 *)0x10002000)
+#define REG_NDMA_SRC_ADDR(n)        ((vu32 *)(0x10002004 + (n) * 0x1C))
+#define REG_NDMA_DST_ADDR(n)        ((vu32 *)(0x10002008 + (n) * 0x1C))
+#define REG_NDMA_TRANSFER_CNT(n)    ((vu32 *)(0x1000200C + (n) * 0x1C))
+#define REG_NDMA_WRITE_CNT(n)       ((vu32 *)(0x10002010 + (n) * 0x1C))
+#define REG_NDMA_BLOCK_CNT(n)       ((vu32 *)(0x10002014 + (n) * 0x1C))
+#define REG_NDMA_CNT(n)             ((vu32 *)(0x1000201C + (n) * 0x1C))
+
+#define NDMA_GLOBAL_ENABLE      0x00000001
+
+#define NDMA_DST_UPDATE_FIXED   0x00000800
+#define NDMA_SRC_UPDATE_FIXED   0x00004000
+#define NDMA_BURST_4_WORDS      0x00020000
+#define NDMA_STARTUP_AES_IN     0x08000000
+#define NDMA_STARTUP_AES_OUT    0x09000000
+#define NDMA_ENABLE             0x80000000
+
+#define NDMA_AES_IN_CHANNEL     0
+#define NDMA_AES_OUT_CHANNEL    1
+
 /**************************SHA****************************/
 #define REG_SHA_CNT         ((vu32 *)0x1000A000)
 #define REG_SHA_BLKCNT      ((vu32 *)0x1000A004)
@@ -112,6 +137,9 @@
 
 extern FirmwareSource firmSource;
 
+void sha_init(u32 mode);
+void sha_update(const void *src, u32 size);
+void sha_get(void *res, u32 mode);
 void sha(void *res, const void *src, u32 size, u32 mode);
 
 int ctrNandInit(void);
@@ -38,6 +38,54 @@
 u32 emuOffset,
     emuHeader;
 
+//Every probed header sector is remembered, as fallbacks and the locateEmuNand calls for the FIRM source probe the same ones
+static struct
+{
+    u32 sector;
+    bool isNcsd;
+} probedHeaders[16];
+static u32 probedHeadersNum = 0;
+
+//Copy of the last NCSD header found, ctrNandInit needs it right after
+static u8 __attribute__((aligned(4))) lastNcsdHeader[0x200];
+static u32 lastNcsdHeaderSector = 0;
+
+static bool isNcsdHeader(u32 sector)
+{
+    static u8 __attribute__((aligned(4))) temp[0x200];
+
+    for(u32 i = 0; i < probedHeadersNum; i++)
+        if(probedHeaders[i].sector == sector) return probedHeaders[i].isNcsd;
+
+    bool isNcsd = !sdmmc_sdcard_readsectors(sector, 1, temp) && memcmp(temp + 0x100, "NCSD", 4) == 0;
+
+    if(isNcsd)
+    {
+        memcpy(lastNcsdHeader, temp, sizeof(lastNcsdHeader));
+        lastNcsdHeaderSector = sector;
+    }
+
+    if(probedHeadersNum < sizeof(probedHeaders) / sizeof(probedHeaders[0]))
+    {
+        probedHeaders[probedHeadersNum].sector = sector;
+        probedHeaders[probedHeadersNum].isNcsd = isNcsd;
+        probedHeadersNum++;
+    }
+
+    return isNcsd;
+}
+
+int readEmuNandHeader(u8 *out)
+{
+    if(lastNcsdHeaderSector != 0 && lastNcsdHeaderSector == emuHeader)
+    {
+        memcpy(out, lastNcsdHeader, sizeof(lastNcsdHeader));
+        return 0;
+    }
+
+    return sdmmc_sdcard_readsectors(emuHeader, 1, out);
+}
+
 void locateEmuNand(FirmwareSource *nandType)
 {
     static u8 __attribute__((aligned(4))) temp[0x200];
@@ -74,7 +122,7 @@ void locateEmuNand(FirmwareSource *nandType)
         if(fatStart >= nandOffset + roundedMinsizes[ISN3DS ? 1 : 0])
         {
             //Check for RedNAND
-            if(!sdmmc_sdcard_readsectors(nandOffset + 1, 1, temp) && memcmp(temp + 0x100, "NCSD", 4) == 0)
+            if(isNcsdHeader(nandOffset + 1))
             {
                 emuOffset = nandOffset + 1;
                 emuHeader = nandOffset + 1;
@@ -82,7 +130,7 @@ void locateEmuNand(FirmwareSource *nandType)
             }
 
             //Check for Gateway EmuNAND
-            else if(i != 2 && !sdmmc_sdcard_readsectors(nandOffset + nandSize, 1, temp) && memcmp(temp + 0x100, "NCSD", 4) == 0)
+            else if(i != 2 && isNcsdHeader(nandOffset + nandSize))
             {
                 emuOffset = nandOffset;
                 emuHeader = nandOffset + nandSize;
@@ -10,11 +10,74 @@
 #include "diskio.h"		/* FatFs lower layer API */
 #include "sdmmc/sdmmc.h"
 #include "../crypto.h"
+#include "../emunand.h"
+#include "../memory.h"
 
 /* Definitions of physical drive number for each media */
 #define SDCARD        0
 #define CTRNAND       1
 
+/* Single sector reads (FAT, directories, FatFs's window) are kept in a small LRU cache.
+   Multi-sector data reads bypass it, writes go through it */
+#define SECTOR_CACHE_SIZE   16
+
+typedef struct SectorCacheEntry {
+    DWORD sector;
+    u32 lastUse;
+    BYTE pdrv;
+    bool isValid;
+} SectorCacheEntry;
+
+static SectorCacheEntry sectorCache[SECTOR_CACHE_SIZE];
+__attribute__((aligned(32))) static BYTE sectorCacheData[SECTOR_CACHE_SIZE][512];
+static u32 sectorCacheTick,
+           ctrNandCacheSource;
+
+static void invalidateSectorCache(BYTE pdrv)
+{
+    for(u32 i = 0; i < SECTOR_CACHE_SIZE; i++)
+        if(sectorCache[i].pdrv == pdrv) sectorCache[i].isValid = false;
+}
+
+static SectorCacheEntry *findCachedSector(BYTE pdrv, DWORD sector)
+{
+    //CTRNAND can be backed by SysNAND or any EmuNAND, and the choice can change without a remount
+    if(pdrv == CTRNAND)
+    {
+        u32 source = firmSource == FIRMWARE_SYSNAND ? 0 : emuOffset | 1;
+        if(source != ctrNandCacheSource)
+        {
+            invalidateSectorCache(CTRNAND);
+            ctrNandCacheSource = source;
+        }
+    }
+
+    for(u32 i = 0; i < SECTOR_CACHE_SIZE; i++)
+        if(sectorCache[i].isValid && sectorCache[i].pdrv == pdrv && sectorCache[i].sector == sector) return &sectorCache[i];
+
+    return NULL;
+}
+
+static void cacheSector(BYTE pdrv, DWORD sector, const BYTE *buff)
+{
+    SectorCacheEntry *entry = findCachedSector(pdrv, sector);
+
+    if(entry == NULL)
+    {
+        //Evict the least recently used entry, empty ones first
+        entry = &sectorCache[0];
+        for(u32 i = 0; i < SECTOR_CACHE_SIZE && entry->isValid; i++)
+            if(!sectorCache[i].isValid || sectorCache[i].lastUse < entry->lastUse) entry = &sectorCache[i];
+
+        entry->pdrv = pdrv;
+        entry->sector = sector;
+        entry->isValid = true;
+    }
+
+    entry->lastUse = ++sectorCacheTick;
+    memcpy(sectorCacheData[entry - sectorCache], buff, 512);
+}
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -41,6 +104,8 @@ DSTATUS disk_initialize (
 
         if(sdmmcInitResult == 4) sdmmcInitResult = sdmmc_sdcard_init();
 
+    invalidateSectorCache(pdrv);
+
     return ((pdrv == SDCARD && !(sdmmcInitResult & 2)) ||
             (pdrv == CTRNAND && !(sdmmcInitResult & 1) && !ctrNandInit())) ? 0 : STA_NOINIT;
 }
@@ -58,8 +123,23 @@ DRESULT disk_read (
 	UINT count		/* Number of sectors to read */
 )
 {
-    return ((pdrv == SDCARD && !sdmmc_sdcard_readsectors(sector, count, buff)) ||
-            (pdrv == CTRNAND && !ctrNandRead(sector, count, buff))) ? RES_OK : RES_PARERR;
+    if(count == 1)
+    {
+        SectorCacheEntry *entry = findCachedSector(pdrv, sector);
+        if(entry != NULL)
+        {
+            entry->lastUse = ++sectorCacheTick;
+            memcpy(buff, sectorCacheData[entry - sectorCache], 512);
+            return RES_OK;
+        }
+    }
+
+    if(!((pdrv == SDCARD && !sdmmc_sdcard_readsectors(sector, count, buff)) ||
+         (pdrv == CTRNAND && !ctrNandRead(sector, count, buff)))) return RES_PARERR;
+
+    if(count == 1) cacheSector(pdrv, sector, buff);
+
+    return RES_OK;
 }
 
 
@@ -76,8 +156,20 @@ DRESULT disk_write (
 	UINT count			/* Number of sectors to write */
 )
 {
-    return ((pdrv == SDCARD && (*(vu16 *)(SDMMC_BASE + REG_SDSTATUS0) & TMIO_STAT0_WRPROTECT) != 0 && !sdmmc_sdcard_writesectors(sector, count, buff)) ||
-            (pdrv == CTRNAND && !ctrNandWrite(sector, count, buff))) ? RES_OK : RES_PARERR;
+    if(!((pdrv == SDCARD && (*(vu16 *)(SDMMC_BASE + REG_SDSTATUS0) & TMIO_STAT0_WRPROTECT) != 0 && !sdmmc_sdcard_writesectors(sector, count, buff)) ||
+         (pdrv == CTRNAND && !ctrNandWrite(sector, count, buff))))
+    {
+        //Don't know what made it to the medium
+        invalidateSectorCache(pdrv);
+        return RES_PARERR;
+    }
+
+    //Write-through: refresh the copies of the sectors that are cached
+    for(u32 i = 0; i < SECTOR_CACHE_SIZE; i++)
+        if(sectorCache[i].isValid && sectorCache[i].pdrv == pdrv && sectorCache[i].sector - sector < count)
+            memcpy(sectorCacheData[i], buff + (sectorCache[i].sector - sector) * 512, 512);
+
+    return RES_OK;
 }
 #endif
 
@@ -12,26 +12,28 @@
 typedef unsigned __int64 QWORD;
 
 
-#else			/* Embedded platform */
+#else			/* Embedded platform, and the host build of storagebench */
+
+#include <stdint.h>
 
 /* These types MUST be 16-bit or 32-bit */
 typedef int				INT;
 typedef unsigned int	UINT;
 
 /* This type MUST be 8-bit */
-typedef unsigned char	BYTE;
+typedef uint8_t			BYTE;
 
 /* These types MUST be 16-bit */
-typedef short			SHORT;
-typedef unsigned short	WORD;
-typedef unsigned short	WCHAR;
+typedef int16_t			SHORT;
+typedef uint16_t		WORD;
+typedef uint16_t		WCHAR;
 
-/* These types MUST be 32-bit */
-typedef long			LONG;
-typedef unsigned long	DWORD;
+/* These types MUST be 32-bit, (unsigned) long on ARM but not on 64-bit hosts */
+typedef int32_t			LONG;
+typedef uint32_t		DWORD;
 
 /* This type MUST be 64-bit (Remove this for ANSI C (C89) compatibility) */
-typedef unsigned long long QWORD;
+typedef uint64_t		QWORD;
 
 #endif
 
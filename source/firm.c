@@ -57,6 +57,76 @@ static __attribute__((noinline)) bool inRange(u32 as, u32 ae, u32 bs, u32 be)
    return false;
 }
 
+//Section hashes computed while the FIRM is being read, see readFirmFile
+static struct
+{
+    u32 section,
+        position,
+        nextOffset;
+    bool isActive,
+         isHashed[4];
+    __attribute__((aligned(4))) u8 hashes[4][0x20];
+} streamedHashes;
+
+static void hashFirmChunk(u32 offset, u32 size)
+{
+    u32 end = offset + size;
+
+    if(!streamedHashes.isActive)
+    {
+        //Wait for the header, then only stream FIRMs whose sections are laid out in order
+        if(offset != 0 || end < 0x200 || memcmp(firm->magic, "FIRM", 4) != 0) return;
+
+        streamedHashes.isActive = true;
+        streamedHashes.nextOffset = 0x200;
+    }
+
+    while(streamedHashes.section < 4)
+    {
+        FirmSection *section = &firm->section[streamedHashes.section];
+
+        if(streamedHashes.position == 0)
+        {
+            if(section->size == 0 || section->offset < streamedHashes.nextOffset || (section->offset & 0x1FF) || (section->size & 0x1FF))
+            {
+                //Leave it (and everything after an out of order section) to checkFirm
+                if(section->size != 0) streamedHashes.nextOffset = 0xFFFFFFFF;
+                streamedHashes.section++;
+                continue;
+            }
+
+            if(section->offset >= end) return;
+
+            sha_init(SHA_256_MODE);
+        }
+
+        u32 from = section->offset + streamedHashes.position,
+            to = section->offset + section->size < end ? section->offset + section->size : end;
+
+        sha_update((u8 *)firm + from, to - from);
+        streamedHashes.position += to - from;
+
+        if(streamedHashes.position != section->size) return;
+
+        sha_get(streamedHashes.hashes[streamedHashes.section], SHA_256_MODE);
+        streamedHashes.isHashed[streamedHashes.section] = true;
+        streamedHashes.nextOffset = section->offset + section->size;
+        streamedHashes.position = 0;
+        streamedHashes.section++;
+    }
+}
+
+static u32 readFirmFile(const char *path, u32 maxSize)
+{
+    memset(&streamedHashes, 0, sizeof(streamedHashes));
+
+    u32 ret = fileReadStreamed(firm, path, maxSize, hashFirmChunk);
+
+    if(!ret) memset(&streamedHashes, 0, sizeof(streamedHashes));
+
+    return ret;
+}
+
 static bool checkFirm(u32 firmSize)
 {
     if(memcmp(firm->magic, "FIRM", 4) != 0 || firm->arm9Entry == NULL) //Allow for the ARM11 entrypoint to be zero in which case nothing is done on the ARM11 side
@@ -71,6 +141,10 @@ static bool checkFirm(u32 firmSize)
 
     if(firmSize < size) return false;
 
+    //Streamed hashes are only valid for the FIRM that was just read, and as long as its sections haven't been touched
+    if(!streamedHashes.isActive) memset(&streamedHashes, 0, sizeof(streamedHashes));
+    streamedHashes.isActive = false;
+
     for(u32 i = 0; i < 4; i++)
     {
         FirmSection *section = &firm->section[i];
@@ -91,7 +165,8 @@ static bool checkFirm(u32 firmSize)
 
         __attribute__((aligned(4))) u8 hash[0x20];
 
-        sha(hash, (u8 *)firm + section->offset, section->size, SHA_256_MODE);
+        if(streamedHashes.isHashed[i]) memcpy(hash, streamedHashes.hashes[i], 0x20);
+        else sha(hash, (u8 *)firm + section->offset, section->size, SHA_256_MODE);
 
         if(memcmp(hash, section->hash, 0x20) != 0)
             return false;
@@ -123,7 +198,7 @@ static inline u32 loadFirmFromStorage(FirmwareType firmType)
         "cetk_sysupdater"
     };
 
-    u32 firmSize = fileRead(firm, firmwareFiles[(u32)firmType], 0x400000 + sizeof(Cxi) + 0x200);
+    u32 firmSize = readFirmFile(firmwareFiles[(u32)firmType], 0x400000 + sizeof(Cxi) + 0x200);
 
     if(!firmSize) return 0;
 
@@ -243,7 +318,7 @@ void loadHomebrewFirm(u32 pressed)
     if(!found) return;
 
     u32 maxPayloadSize = (u32)((u8 *)0x27FFE000 - (u8 *)firm),
-        payloadSize = fileRead(firm, path, maxPayloadSize);
+        payloadSize = readFirmFile(path, maxPayloadSize);
 
     if(payloadSize <= 0x200 || !checkFirm(payloadSize)) error("El payload es invalido o corrupto.");
 
@@ -378,8 +453,8 @@ u32 patchNativeFirm(u32 firmVersion, FirmwareSource nandType, bool loadFromStora
         ret += patchKernel11(arm11Section1, firm->section[1].size, baseK11VA, arm11SvcTable, arm11ExceptionsPage);
     }
 
-    //Apply signature patches
-    ret += patchSignatureChecks(process9Offset, process9Size);
+    //Apply the signature, NCCH encryption dev unit checks, anti-anti-DG, UNITINFO and Process9 access checks patches
+    ret += patchNativeFirmProcess9(process9Offset, process9Size, firmVersion, doUnitinfoPatch);
 
     //Apply EmuNAND patches
     if(nandType != FIRMWARE_SYSNAND) ret += patchEmuNand(arm9Section, kernel9Size, process9Offset, process9Size, firm->section[2].address, firmVersion);
@@ -390,30 +465,14 @@ u32 patchNativeFirm(u32 firmVersion, FirmwareSource nandType, bool loadFromStora
     //Apply firmlaunch patches
     ret += patchFirmlaunches(process9Offset, process9Size, process9MemAddr);
 
-    //Apply dev unit check patches related to NCCH encryption
-    if(!ISDEVUNIT)
-    {
-        ret += patchZeroKeyNcchEncryptionCheck(process9Offset, process9Size);
-        ret += patchNandNcchEncryptionCheck(process9Offset, process9Size);
-    }
-
-    //Apply anti-anti-DG patches on 11.0+
-    if(firmVersion >= (ISN3DS ? 0x21 : 0x52)) ret += patchTitleInstallMinVersionChecks(process9Offset, process9Size, firmVersion);
-
     //Apply UNITINFO patches
-    if(doUnitinfoPatch)
-    {
-        ret += patchUnitInfoValueSet(arm9Section, kernel9Size);
-        if(!ISDEVUNIT) ret += patchCheckForDevCommonKey(process9Offset, process9Size);
-    }
+    if(doUnitinfoPatch) ret += patchUnitInfoValueSet(arm9Section, kernel9Size);
 
     //ARM9 exception handlers
     ret += patchArm9ExceptionHandlersInstall(arm9Section, kernel9Size);
     ret += patchSvcBreak9(arm9Section, kernel9Size, (u32)firm->section[2].address);
     ret += patchKernel9Panic(arm9Section, kernel9Size);
 
-    ret += patchP9AccessChecks(process9Offset, process9Size);
-
     mergeSection0(NATIVE_FIRM, firmVersion, loadFromStorage);
     firm->section[0].size = 0;
 
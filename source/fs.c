@@ -42,6 +42,27 @@
 static FATFS sdFs,
              nandFs;
 
+#define PAYLOAD_MENU_MAX 20
+
+//In findPayload()'s priority order, "select" is used when none of the others is pressed
+static const struct {
+    u32 button;
+    const char *name;
+} payloadButtons[] = {
+    {BUTTON_LEFT, "left"}, {BUTTON_RIGHT, "right"}, {BUTTON_UP, "up"}, {BUTTON_DOWN, "down"}, {BUTTON_START, "start"},
+    {BUTTON_B, "b"}, {BUTTON_X, "x"}, {BUTTON_Y, "y"}, {BUTTON_R1, "r"}, {BUTTON_A, "a"}, {0, "select"}
+};
+
+#define NB_PAYLOAD_BUTTONS (sizeof(payloadButtons) / sizeof(payloadButtons[0]))
+
+//Everything findPayload() and payloadMenu() need, from a single pass over the payloads folder of the mounted drive
+static struct {
+    bool isValid;
+    u32 menuNum;
+    char menuNames[PAYLOAD_MENU_MAX][49];
+    char buttonPayloads[NB_PAYLOAD_BUTTONS][FF_MAX_LFN + 1];
+} payloadIndex;
+
 static bool switchToMainDir(bool isSd)
 {
     const char *mainDir = isSd ? "/luma" : "/rw/luma";
@@ -59,11 +80,13 @@ static bool switchToMainDir(bool isSd)
 
 bool mountFs(bool isSd, bool switchToCtrNand)
 {
+    payloadIndex.isValid = false;
+
     return isSd ? f_mount(&sdFs, "0:", 1) == FR_OK && switchToMainDir(true) :
                   f_mount(&nandFs, "1:", 1) == FR_OK && (!switchToCtrNand || (f_chdrive("1:") == FR_OK && switchToMainDir(false)));
 }
 
-u32 fileRead(void *dest, const char *path, u32 maxSize)
+u32 fileReadStreamed(void *dest, const char *path, u32 maxSize, void (*onChunkRead)(u32 offset, u32 size))
 {
     FIL file;
     FRESULT result = FR_OK;
@@ -74,12 +97,37 @@ u32 fileRead(void *dest, const char *path, u32 maxSize)
     u32 size = f_size(&file);
     if(dest == NULL) ret = size;
     else if(size <= maxSize)
-        result = f_read(&file, dest, size, (unsigned int *)&ret);
+    {
+        //Map the cluster chain in one go rather than following it through the FAT while reading
+        DWORD linkMap[FILE_LINK_MAP_SIZE];
+        linkMap[0] = FILE_LINK_MAP_SIZE;
+        file.cltbl = linkMap;
+        if(f_lseek(&file, CREATE_LINKMAP) != FR_OK) file.cltbl = NULL;
+
+        if(onChunkRead == NULL) result = f_read(&file, dest, size, (unsigned int *)&ret);
+        else while(ret < size && result == FR_OK)
+        {
+            //Let the caller process each chunk as soon as it is in memory
+            u32 chunkSize = size - ret < FILE_READ_CHUNK_SIZE ? size - ret : FILE_READ_CHUNK_SIZE;
+            unsigned int read;
+
+            result = f_read(&file, (u8 *)dest + ret, chunkSize, &read);
+            if(result != FR_OK || read == 0) break;
+
+            onChunkRead(ret, read);
+            ret += read;
+        }
+    }
     result |= f_close(&file);
 
     return result == FR_OK ? ret : 0;
 }
 
+u32 fileRead(void *dest, const char *path, u32 maxSize)
+{
+    return fileReadStreamed(dest, path, maxSize, NULL);
+}
+
 u32 getFileSize(const char *path)
 {
     return fileRead(NULL, path, 0);
@@ -122,67 +170,90 @@ bool fileDelete(const char *path)
     return f_unlink(path) == FR_OK;
 }
 
-bool findPayload(char *path, u32 pressed)
+static inline char toLowerAscii(char c)
 {
-    const char *pattern;
-
-    if(pressed & BUTTON_LEFT) pattern = PATTERN("left");
-    else if(pressed & BUTTON_RIGHT) pattern = PATTERN("right");
-    else if(pressed & BUTTON_UP) pattern = PATTERN("up");
-    else if(pressed & BUTTON_DOWN) pattern = PATTERN("down");
-    else if(pressed & BUTTON_START) pattern = PATTERN("start");
-    else if(pressed & BUTTON_B) pattern = PATTERN("b");
-    else if(pressed & BUTTON_X) pattern = PATTERN("x");
-    else if(pressed & BUTTON_Y) pattern = PATTERN("y");
-    else if(pressed & BUTTON_R1) pattern = PATTERN("r");
-    else if(pressed & BUTTON_A) pattern = PATTERN("a");
-    else pattern = PATTERN("select");
-
-    DIR dir;
-    FILINFO info;
-    FRESULT result;
-
-    result = f_findfirst(&dir, &info, "payloads", pattern);
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
 
-    if(result != FR_OK) return false;
+//Case-insensitive like the "<button>_*.firm" wildcard f_findfirst used to match
+static bool isButtonPayload(const char *name, u32 nameLength, const char *button)
+{
+    u32 buttonLength = strlen(button);
 
-    f_closedir(&dir);
+    if(nameLength < buttonLength + 6 || name[buttonLength] != '_') return false;
 
-    if(!info.fname[0]) return false;
+    for(u32 i = 0; i < buttonLength; i++)
+        if(toLowerAscii(name[i]) != button[i]) return false;
 
-    sprintf(path, "payloads/%s", info.fname);
+    for(u32 i = 0; i < 5; i++)
+        if(toLowerAscii(name[nameLength - 5 + i]) != ".firm"[i]) return false;
 
     return true;
 }
 
-bool payloadMenu(char *path)
+static bool indexPayloads(void)
 {
+    if(payloadIndex.isValid) return true;
+
     DIR dir;
 
     if(f_opendir(&dir, "payloads") != FR_OK) return false;
 
     FILINFO info;
-    u32 payloadNum = 0;
-    char payloadList[20][49];
+    u32 nbButtonsLeft = NB_PAYLOAD_BUTTONS;
 
-    while(f_readdir(&dir, &info) == FR_OK && info.fname[0] != 0 && payloadNum < 20)
-    {
-        if(info.fname[0] == '.') continue;
+    payloadIndex.menuNum = 0;
+    for(u32 i = 0; i < NB_PAYLOAD_BUTTONS; i++) payloadIndex.buttonPayloads[i][0] = 0;
 
+    while((payloadIndex.menuNum < PAYLOAD_MENU_MAX || nbButtonsLeft != 0) && f_readdir(&dir, &info) == FR_OK && info.fname[0] != 0)
+    {
         u32 nameLength = strlen(info.fname);
 
-        if(nameLength < 6 || nameLength > 52) continue;
+        //The first match in directory order, as f_findfirst would return
+        for(u32 i = 0; i < NB_PAYLOAD_BUTTONS; i++)
+        {
+            if(payloadIndex.buttonPayloads[i][0] != 0 || !isButtonPayload(info.fname, nameLength, payloadButtons[i].name)) continue;
+
+            memcpy(payloadIndex.buttonPayloads[i], info.fname, nameLength + 1);
+            nbButtonsLeft--;
+        }
+
+        if(payloadIndex.menuNum == PAYLOAD_MENU_MAX || info.fname[0] == '.' || nameLength < 6 || nameLength > 52) continue;
 
         nameLength -= 5;
 
         if(memcmp(info.fname + nameLength, ".firm", 5) != 0) continue;
 
-        memcpy(payloadList[payloadNum], info.fname, nameLength);
-        payloadList[payloadNum][nameLength] = 0;
-        payloadNum++;
+        memcpy(payloadIndex.menuNames[payloadIndex.menuNum], info.fname, nameLength);
+        payloadIndex.menuNames[payloadIndex.menuNum][nameLength] = 0;
+        payloadIndex.menuNum++;
     }
 
-    if(f_closedir(&dir) != FR_OK || !payloadNum) return false;
+    payloadIndex.isValid = f_closedir(&dir) == FR_OK;
+
+    return payloadIndex.isValid;
+}
+
+bool findPayload(char *path, u32 pressed)
+{
+    if(!indexPayloads()) return false;
+
+    u32 i;
+    for(i = 0; i < NB_PAYLOAD_BUTTONS - 1 && !(pressed & payloadButtons[i].button); i++);
+
+    if(!payloadIndex.buttonPayloads[i][0]) return false;
+
+    sprintf(path, "payloads/%s", payloadIndex.buttonPayloads[i]);
+
+    return true;
+}
+
+bool payloadMenu(char *path)
+{
+    if(!indexPayloads() || !payloadIndex.menuNum) return false;
+
+    u32 payloadNum = payloadIndex.menuNum;
+    char (*payloadList)[49] = payloadIndex.menuNames;
 
     u32 pressed = 0,
         selectedPayload = 0;
@@ -28,9 +28,11 @@
 
 #include "types.h"
 
-#define PATTERN(a) a "_*.firm"
+#define FILE_READ_CHUNK_SIZE 0x20000
+#define FILE_LINK_MAP_SIZE 64 //Enough for 31 fragments, more fragmented files are read without it
 
 bool mountFs(bool isSd, bool switchToCtrNand);
+u32 fileReadStreamed(void *dest, const char *path, u32 maxSize, void (*onChunkRead)(u32 offset, u32 size));
 u32 fileRead(void *dest, const char *path, u32 maxSize);
 u32 getFileSize(const char *path);
 bool fileWrite(const void *buffer, const char *path, u32 size);
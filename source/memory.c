@@ -24,72 +24,23 @@
 *         reasonable ways as different from the original version.
 */
 
-/*
-*   Boyer-Moore Horspool algorithm adapted from http://www-igm.univ-mlv.fr/~lecroq/string/node18.html#SECTION00180
-*   memcpy, memset32 and memcmp adapted from https://github.com/mid-kid/CakesForeveryWan/blob/557a8e8605ab3ee173af6497486e8f22c261d0e2/source/memfuncs.c
-*/
-
 #include "memory.h"
 
-void memcpy(void *dest, const void *src, u32 size)
-{
-    u8 *destc = (u8 *)dest;
-    const u8 *srcc = (const u8 *)src;
-
-    for(u32 i = 0; i < size; i++)
-        destc[i] = srcc[i];
-}
-
 void memset(void *dest, u32 filler, u32 size)
 {
     u8 *destc = (u8 *)dest;
 
-    for(u32 i = 0; i < size; i++)
-        destc[i] = (u8)filler;
-}
+    for(; ((u32)destc & 3) != 0 && size != 0; size--)
+        *destc++ = (u8)filler;
 
-void memset32(void *dest, u32 filler, u32 size)
-{
-    u32 *dest32 = (u32 *)dest;
-
-    for(u32 i = 0; i < size / 4; i++)
-        dest32[i] = filler;
-}
-
-int memcmp(const void *buf1, const void *buf2, u32 size)
-{
-    const u8 *buf1c = (const u8 *)buf1,
-             *buf2c = (const u8 *)buf2;
-
-    for(u32 i = 0; i < size; i++)
-    {
-        int cmp = buf1c[i] - buf2c[i];
-        if(cmp != 0) return cmp;
-    }
-
-    return 0;
-}
-
-u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize)
-{
-    const u8 *patternc = (const u8 *)pattern;
-    u32 table[256];
+    u32 *dest32 = (u32 *)destc,
+        filler32 = (filler & 0xFF) * 0x01010101;
 
-    //Preprocessing
-    for(u32 i = 0; i < 256; i++)
-        table[i] = patternSize;
-    for(u32 i = 0; i < patternSize - 1; i++)
-        table[patternc[i]] = patternSize - i - 1;
+    for(; size >= 4; size -= 4)
+        *dest32++ = filler32;
 
-    //Searching
-    u32 j = 0;
-    while(j <= size - patternSize)
-    {
-        u8 c = startPos[j + patternSize - 1];
-        if(patternc[patternSize - 1] == c && memcmp(pattern, startPos + j, patternSize - 1) == 0)
-            return startPos + j;
-        j += table[c];
-    }
+    destc = (u8 *)dest32;
 
-    return NULL;
+    for(; size != 0; size--)
+        *destc++ = (u8)filler;
 }
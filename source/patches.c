@@ -260,22 +260,86 @@ u32 patchKernel11(u8 *pos, u32 size, u32 baseK11VA, u32 *arm11SvcTable, u32 *arm
     return 0;
 }
 
+u32 applyFirmPatches(u8 *pos, u32 size, const FirmPatch *patches, u32 patchesNum, u32 firmVersion, bool doUnitinfoPatch)
+{
+    u8 *targets[32] = {NULL};
+    u32 firstByteMasks[256] = {0},
+        pending = 0,
+        ret = 0;
+
+    if(patchesNum > 32) return patchesNum;
+
+    for(u32 i = 0; i < patchesNum; i++)
+    {
+        if(firmVersion < patches[i].minVersion[ISN3DS ? 1 : 0] ||
+           ((patches[i].flags & FIRM_PATCH_RETAIL_ONLY) && ISDEVUNIT) ||
+           ((patches[i].flags & FIRM_PATCH_UNITINFO) && !doUnitinfoPatch)) continue;
+
+        firstByteMasks[patches[i].pattern[0]] |= 1u << i;
+        pending |= 1u << i;
+    }
+
+    //Resolve every pattern in a single sweep, keeping the first match of each like memsearch does
+    for(u32 j = 0; pending != 0 && j + 4 <= size; j++)
+    {
+        u32 candidates = firstByteMasks[pos[j]] & pending;
+
+        while(candidates != 0)
+        {
+            u32 i = __builtin_ctz(candidates);
+            candidates &= candidates - 1;
+
+            if(memcmp(pos + j, patches[i].pattern, 4) == 0)
+            {
+                targets[i] = pos + j;
+                pending &= ~(1u << i);
+            }
+        }
+    }
+
+    for(u32 i = 0; i < patchesNum; i++)
+    {
+        if(targets[i] != NULL) memcpy(targets[i] + patches[i].offset, patches[i].replacement, patches[i].replacementSize);
+
+        //Patches that were enabled but not found
+        else if(pending & (1u << i)) ret += (patches[i].flags & FIRM_PATCH_OPTIONAL) && firmVersion == 0xFFFFFFFF ? 0 : 1;
+    }
+
+    return ret;
+}
+
+//Look for signature checks
+#define SIGNATURE_CHECKS_PATCHES \
+    {{0xC0, 0x1C, 0x76, 0xE7},  0, {0x00, 0x20}, 2, {0, 0}, 0}, /* movs r0, #0 */ \
+    {{0xB5, 0x22, 0x4D, 0x0C}, -1, {0x00, 0x20, 0x70, 0x47}, 4, {0, 0}, 0} /* movs r0, #0; bx lr */
+
 u32 patchSignatureChecks(u8 *pos, u32 size)
 {
-    //Look for signature checks
-    static const u8 pattern[] = {0xC0, 0x1C, 0x76, 0xE7},
-                    pattern2[] = {0xB5, 0x22, 0x4D, 0x0C};
+    static const FirmPatch patches[] = {SIGNATURE_CHECKS_PATCHES};
 
-    u16 *off = (u16 *)memsearch(pos, pattern, size, sizeof(pattern));
-    u8 *temp = memsearch(pos, pattern2, size, sizeof(pattern2));
+    return applyFirmPatches(pos, size, patches, sizeof(patches) / sizeof(FirmPatch), 0, false);
+}
 
-    if(off == NULL || temp == NULL) return 1;
+u32 patchNativeFirmProcess9(u8 *pos, u32 size, u32 firmVersion, bool doUnitinfoPatch)
+{
+    static const FirmPatch patches[] = {
+        SIGNATURE_CHECKS_PATCHES,
 
-    u16 *off2 = (u16 *)(temp - 1);
-    *off = off2[0] = 0x2000;
-    off2[1] = 0x4770;
+        //Dev unit checks related to NCCH encryption
+        {{0x28, 0x2A, 0xD0, 0x08}, -1, {0x01, 0x20}, 2, {0, 0}, FIRM_PATCH_RETAIL_ONLY}, /* movs r0, #1 */
+        {{0x07, 0xD1, 0x28, 0x7A}, -2, {0x01, 0x20}, 2, {0, 0}, FIRM_PATCH_RETAIL_ONLY}, /* movs r0, #1 */
 
-    return 0;
+        //Anti-anti-DG on 11.0+: zero out the first TitleID in the list
+        {{0xFF, 0x00, 0x00, 0x02},  1, {0}, 8, {0x52, 0x21}, FIRM_PATCH_OPTIONAL},
+
+        //UNITINFO
+        {{0x03, 0x7C, 0x28, 0x00},  0, {0x01, 0x23}, 2, {0, 0}, FIRM_PATCH_RETAIL_ONLY | FIRM_PATCH_UNITINFO}, /* movs r3, #1 */
+
+        //Process9 access checks
+        {{0x00, 0x08, 0x49, 0x68}, -3, {0x01, 0x20, 0x70, 0x47}, 4, {0, 0}, 0}, /* movs r0, #1; bx lr */
+    };
+
+    return applyFirmPatches(pos, size, patches, sizeof(patches) / sizeof(FirmPatch), firmVersion, doUnitinfoPatch);
 }
 
 u32 patchOldSignatureChecks(u8 *pos, u32 size)
@@ -362,63 +426,6 @@ u32 patchOldFirmWrites(u8 *pos, u32 size)
     return 0;
 }
 
-u32 patchTitleInstallMinVersionChecks(u8 *pos, u32 size, u32 firmVersion)
-{
-    static const u8 pattern[] = {0xFF, 0x00, 0x00, 0x02};
-
-    u8 *off = memsearch(pos, pattern, size, sizeof(pattern));
-
-    if(off == NULL) return firmVersion == 0xFFFFFFFF ? 0 : 1;
-
-    off++;
-
-    //Zero out the first TitleID in the list
-    memset32(off, 0, 8);
-
-    return 0;
-}
-
-u32 patchZeroKeyNcchEncryptionCheck(u8 *pos, u32 size)
-{
-    static const u8 pattern[] = {0x28, 0x2A, 0xD0, 0x08};
-
-    u8 *temp = memsearch(pos, pattern, size, sizeof(pattern));
-
-    if(temp == NULL) return 1;
-
-    u16 *off = (u16 *)(temp - 1);
-    *off = 0x2001; //mov r0, #1
-
-    return 0;
-}
-
-u32 patchNandNcchEncryptionCheck(u8 *pos, u32 size)
-{
-    static const u8 pattern[] = {0x07, 0xD1, 0x28, 0x7A};
-
-    u16 *off = (u16 *)memsearch(pos, pattern, size, sizeof(pattern));
-
-    if(off == NULL) return 1;
-
-    off--;
-    *off = 0x2001; //mov r0, #1
-
-    return 0;
-}
-
-u32 patchCheckForDevCommonKey(u8 *pos, u32 size)
-{
-    static const u8 pattern[] = {0x03, 0x7C, 0x28, 0x00};
-
-    u16 *off = (u16 *)memsearch(pos, pattern, size, sizeof(pattern));
-
-    if(off == NULL) return 1;
-
-    *off = 0x2301; //mov r3, #1
-
-    return 0;
-}
-
 u32 patchK11ModuleLoading(u32 section0size, u32 modulesSize, u8 *pos, u32 size)
 {
     static const u8 moduleLoadingPattern[]  = {0xE2, 0x05, 0x00, 0x57},
@@ -520,21 +527,6 @@ u32 patchKernel9Panic(u8 *pos, u32 size)
     return 0;
 }
 
-u32 patchP9AccessChecks(u8 *pos, u32 size)
-{
-    static const u8 pattern[] = {0x00, 0x08, 0x49, 0x68};
-
-    u8 *temp = memsearch(pos, pattern, size, sizeof(pattern));
-
-    if(temp == NULL) return 1;
-
-    u16 *off = (u16 *)(temp - 3);
-    off[0] = 0x2001; //mov r0, #1
-    off[1] = 0x4770; //bx lr
-
-    return 0;
-}
-
 u32 patchUnitInfoValueSet(u8 *pos, u32 size)
 {
     //Look for UNITINFO value being set during kernel sync
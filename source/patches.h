@@ -37,24 +37,36 @@
 
 #include "types.h"
 
+//A 4-byte pattern whose first match gets the replacement written at a fixed offset from it
+typedef struct FirmPatch
+{
+    u8 pattern[4];
+    s32 offset;
+    u8 replacement[8];
+    u32 replacementSize;
+    u32 minVersion[2]; //O3DS, N3DS. External FIRMs (version 0xFFFFFFFF) always qualify
+    u32 flags;
+} FirmPatch;
+
+#define FIRM_PATCH_RETAIL_ONLY  (1 << 0) //Not applied on dev units
+#define FIRM_PATCH_UNITINFO     (1 << 1) //Only applied when patching UNITINFO
+#define FIRM_PATCH_OPTIONAL     (1 << 2) //Not an error when missing from a FIRM of unknown version
+
 u8 *getProcess9Info(u8 *pos, u32 size, u32 *process9Size, u32 *process9MemAddr);
 u32 *getKernel11Info(u8 *pos, u32 size, u32 *baseK11VA, u8 **freeK11Space, u32 **arm11SvcHandler, u32 **arm11ExceptionsPage);
 u32 installK11Extension(u8 *pos, u32 size, bool needToInitSd, u32 baseK11VA, u32 *arm11ExceptionsPage, u8 **freeK11Space); 
 u32 patchKernel11(u8 *pos, u32 size, u32 baseK11VA, u32 *arm11SvcTable, u32 *arm11ExceptionsPage);
+u32 applyFirmPatches(u8 *pos, u32 size, const FirmPatch *patches, u32 patchesNum, u32 firmVersion, bool doUnitinfoPatch);
 u32 patchSignatureChecks(u8 *pos, u32 size);
+u32 patchNativeFirmProcess9(u8 *pos, u32 size, u32 firmVersion, bool doUnitinfoPatch);
 u32 patchOldSignatureChecks(u8 *pos, u32 size);
 u32 patchFirmlaunches(u8 *pos, u32 size, u32 process9MemAddr);
 u32 patchFirmWrites(u8 *pos, u32 size);
 u32 patchOldFirmWrites(u8 *pos, u32 size);
-u32 patchTitleInstallMinVersionChecks(u8 *pos, u32 size, u32 firmVersion);
-u32 patchZeroKeyNcchEncryptionCheck(u8 *pos, u32 size);
-u32 patchNandNcchEncryptionCheck(u8 *pos, u32 size);
-u32 patchCheckForDevCommonKey(u8 *pos, u32 size);
 u32 patchK11ModuleLoading(u32 section0size, u32 modulesSize, u8 *startPos, u32 size);
 u32 patchArm9ExceptionHandlersInstall(u8 *pos, u32 size);
 u32 patchSvcBreak9(u8 *pos, u32 size, u32 kernel9Address);
 u32 patchKernel9Panic(u8 *pos, u32 size);
-u32 patchP9AccessChecks(u8 *pos, u32 size);
 u32 patchUnitInfoValueSet(u8 *pos, u32 size);
 u32 patchLgySignatureChecks(u8 *pos, u32 size);
 u32 patchTwlInvalidSignatureChecks(u8 *pos, u32 size);
@@ -0,0 +1,119 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2018 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/*
+*   The sdmmc driver and the CTRNAND crypto for the host, over image files.
+*   diskio.c and its sector cache sit on top unchanged, so the counters only see what reaches the card.
+*   The CTRNAND image is the decrypted FAT partition: there's no AES engine here.
+*   Both images are opened read-only, writes fail.
+*/
+
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "drives.h"
+#include "crypto.h"
+#include "fatfs/sdmmc/sdmmc.h"
+
+DriveStats sdStats,
+           ctrNandStats;
+
+//diskio.c only looks at these to tell SysNAND from EmuNAND
+FirmwareSource firmSource = FIRMWARE_SYSNAND;
+u32 emuOffset = 0;
+
+static int sdFd = -1,
+           ctrNandFd = -1;
+static u32 sdSectors,
+           ctrNandSectors;
+
+static int openImage(const char *path, u32 *sectors)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if(fd < 0) return -1;
+
+    if(fstat(fd, &st) != 0 || st.st_size / 512 > 0xFFFFFFFF)
+    {
+        close(fd);
+        return -1;
+    }
+
+    *sectors = (u32)(st.st_size / 512);
+
+    return fd;
+}
+
+bool openDrives(const char *sdImagePath, const char *ctrNandImagePath)
+{
+    sdFd = openImage(sdImagePath, &sdSectors);
+    if(ctrNandImagePath != NULL) ctrNandFd = openImage(ctrNandImagePath, &ctrNandSectors);
+
+    return sdFd >= 0 && (ctrNandImagePath == NULL || ctrNandFd >= 0);
+}
+
+static int readImage(int fd, u32 nbSectors, DriveStats *stats, u32 sector, u32 sectorCount, u8 *out)
+{
+    if(fd < 0 || sector >= nbSectors || sectorCount > nbSectors - sector) return 1;
+
+    stats->commands++;
+    stats->sectors += sectorCount;
+
+    return pread(fd, out, (size_t)sectorCount * 512, (off_t)sector * 512) == (ssize_t)sectorCount * 512 ? 0 : 1;
+}
+
+//Same convention as the real driver: bit 0 is a NAND failure, bit 1 an SD one
+u32 sdmmc_sdcard_init(void)
+{
+    return (sdFd < 0 ? 2 : 0) | (ctrNandFd < 0 ? 1 : 0);
+}
+
+int sdmmc_sdcard_readsectors(u32 sector_no, u32 numsectors, u8 *out)
+{
+    return readImage(sdFd, sdSectors, &sdStats, sector_no, numsectors, out);
+}
+
+int sdmmc_sdcard_writesectors(__attribute__((unused)) u32 sector_no, __attribute__((unused)) u32 numsectors, __attribute__((unused)) const u8 *in)
+{
+    return 1;
+}
+
+int ctrNandInit(void)
+{
+    return ctrNandFd < 0;
+}
+
+int ctrNandRead(u32 sector, u32 sectorCount, u8 *outbuf)
+{
+    return readImage(ctrNandFd, ctrNandSectors, &ctrNandStats, sector, sectorCount, outbuf);
+}
+
+int ctrNandWrite(__attribute__((unused)) u32 sector, __attribute__((unused)) u32 sectorCount, __attribute__((unused)) const u8 *inbuf)
+{
+    return 1;
+}
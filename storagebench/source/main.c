@@ -0,0 +1,236 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2018 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/*
+*   Replays the storage accesses of a Luma3DS boot against SD and CTRNAND images, through the real
+*   fs.c, FatFs and diskio.c, and reports the card commands and sectors each step costs.
+*
+*   Usage: storagebench <sd.img> [ctrnand.img] [button]
+*   The SD image needs a /luma folder: creating it would need a write.
+*   button is one of the payload buttons (left, right, ..., a), select by default.
+*/
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "drives.h"
+#include "fs.h"
+#include "screen.h"
+#include "buttons.h"
+#include "fatfs/ff.h"
+
+//Between the FIRM buffer and the end of ARM9 memory, as in loadHomebrewFirm()
+#define MAX_PAYLOAD_SIZE    (0x27FFE000 - 0x20001000)
+#define MAX_FIRM_SIZE       0x400000
+
+static const struct {
+    const char *name;
+    u32 button;
+} buttons[] = {
+    {"left", BUTTON_LEFT}, {"right", BUTTON_RIGHT}, {"up", BUTTON_UP}, {"down", BUTTON_DOWN}, {"start", BUTTON_START},
+    {"b", BUTTON_B}, {"x", BUTTON_X}, {"y", BUTTON_Y}, {"r", BUTTON_R1}, {"a", BUTTON_A}, {"select", 0}
+};
+
+static struct {
+    DriveStats sd, ctrNand;
+    struct timespec time;
+} stepStart;
+
+static DriveStats total;
+static u32 nbChunks;
+
+static void beginStep(void)
+{
+    stepStart.sd = sdStats;
+    stepStart.ctrNand = ctrNandStats;
+    clock_gettime(CLOCK_MONOTONIC, &stepStart.time);
+}
+
+static void endStep(const char *name, const char *result)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    u64 commands = sdStats.commands - stepStart.sd.commands + ctrNandStats.commands - stepStart.ctrNand.commands,
+        sectors = sdStats.sectors - stepStart.sd.sectors + ctrNandStats.sectors - stepStart.ctrNand.sectors,
+        us = (u64)(now.tv_sec - stepStart.time.tv_sec) * 1000000 + (u64)(now.tv_nsec - stepStart.time.tv_nsec) / 1000;
+
+    total.commands += commands;
+    total.sectors += sectors;
+
+    printf("%-24s %-24s %8llu %8llu %10llu %8llu\n", name, result, (unsigned long long)commands, (unsigned long long)sectors,
+           (unsigned long long)sectors * 512, (unsigned long long)us);
+}
+
+static const char *sizeResult(u32 size, u32 expectedSize)
+{
+    static char result[24];
+
+    if(size == 0) return "missing";
+
+    snprintf(result, sizeof(result), size == expectedSize || expectedSize == 0 ? "%u bytes" : "%u bytes, invalid", size);
+
+    return result;
+}
+
+static void onPayloadChunk(__attribute__((unused)) u32 offset, __attribute__((unused)) u32 size)
+{
+    nbChunks++;
+}
+
+//firmRead() picks the folder with ISN3DS, which reads a CFG11 register: map it and leave it zeroed, for an Old 3DS
+static bool mapSocInfo(void)
+{
+    void *page = (void *)((uintptr_t)&CFG11_SOCINFO & ~(uintptr_t)0xFFF);
+
+    return mmap(page, 0x1000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) == page;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s <sd.img> [ctrnand.img] [button]\n", argv[0]);
+        return 1;
+    }
+
+    const char *ctrNandImagePath = argc >= 3 && argv[2][0] != 0 ? argv[2] : NULL,
+               *buttonName = argc == 4 ? argv[3] : "select";
+
+    u32 i;
+    for(i = 0; i < sizeof(buttons) / sizeof(buttons[0]) && strcmp(buttons[i].name, buttonName) != 0; i++);
+
+    if(i == sizeof(buttons) / sizeof(buttons[0]))
+    {
+        fprintf(stderr, "Unknown button: %s\n", buttonName);
+        return 1;
+    }
+
+    u32 pressed = buttons[i].button;
+
+    if(!openDrives(argv[1], ctrNandImagePath))
+    {
+        perror("Couldn't open the images");
+        return 1;
+    }
+
+    //mountFs() would create a missing /luma, and writes aren't supported
+    FATFS fs;
+    DIR dir;
+    if(f_mount(&fs, "0:", 1) != FR_OK || f_opendir(&dir, "0:/luma") != FR_OK)
+    {
+        fprintf(stderr, "%s isn't a FAT image with a /luma folder\n", argv[1]);
+        return 1;
+    }
+    f_closedir(&dir);
+    f_mount(NULL, "0:", 0);
+
+    //Remounting goes through disk_initialize(), which empties the sector cache: every step below starts from a cold boot
+    sdStats = (DriveStats){0};
+
+    printf("%-24s %-24s %8s %8s %10s %8s\n", "Step", "Result", "Commands", "Sectors", "Bytes", "Host us");
+
+    beginStep();
+    endStep("Mount SD", mountFs(true, false) ? "ok" : "failed");
+
+    static CfgData config;
+    static PinData pin;
+    static u8 splash[SCREEN_TOP_FBSIZE];
+
+    beginStep();
+    endStep("Read config.bin", sizeResult(fileRead(&config, "config.bin", sizeof(CfgData)), sizeof(CfgData)));
+
+    beginStep();
+    endStep("Read pin.bin", sizeResult(fileRead(&pin, "pin.bin", sizeof(PinData)), sizeof(PinData)));
+
+    //As loadSplash() does
+    beginStep();
+    u32 topSplashSize = getFileSize("splash.bin"),
+        bottomSplashSize = getFileSize("splashbottom.bin");
+    endStep("Check the splash images", topSplashSize == SCREEN_TOP_FBSIZE || bottomSplashSize == SCREEN_BOTTOM_FBSIZE ? "found" : "none");
+
+    if(topSplashSize == SCREEN_TOP_FBSIZE)
+    {
+        beginStep();
+        endStep("Read splash.bin", sizeResult(fileRead(splash, "splash.bin", SCREEN_TOP_FBSIZE), SCREEN_TOP_FBSIZE));
+    }
+
+    if(bottomSplashSize == SCREEN_BOTTOM_FBSIZE)
+    {
+        beginStep();
+        endStep("Read splashbottom.bin", sizeResult(fileRead(splash, "splashbottom.bin", SCREEN_BOTTOM_FBSIZE), SCREEN_BOTTOM_FBSIZE));
+    }
+
+    char path[10 + 255];
+
+    beginStep();
+    bool found = findPayload(path, pressed);
+    endStep("Find the payload", found ? path + sizeof("payloads/") - 1 : "none");
+
+    if(found)
+    {
+        u8 *payload = malloc(MAX_PAYLOAD_SIZE);
+
+        beginStep();
+        u32 payloadSize = fileReadStreamed(payload, path, MAX_PAYLOAD_SIZE, onPayloadChunk);
+        endStep("Read the payload", sizeResult(payloadSize, 0));
+
+        printf("  %u chunks\n", nbChunks);
+        free(payload);
+    }
+
+    //Reuses the index findPayload() built, it should cost nothing
+    beginStep();
+    found = payloadMenu(path);
+    endStep("Payload menu", found ? path + sizeof("payloads/") - 1 : "none");
+
+    if(ctrNandImagePath != NULL)
+    {
+        beginStep();
+        endStep("Mount CTRNAND", mountFs(false, false) ? "ok" : "failed");
+
+        if(mapSocInfo())
+        {
+            u8 *firm = malloc(MAX_FIRM_SIZE + 0x400);
+
+            beginStep();
+            u32 firmVersion = firmRead(firm, NATIVE_FIRM);
+            char result[24];
+            snprintf(result, sizeof(result), firmVersion == 0xFFFFFFFF ? "not found" : "%08x.app", firmVersion);
+            endStep("Read NATIVE_FIRM", result);
+
+            free(firm);
+        }
+        else printf("Couldn't emulate CFG11_SOCINFO, skipping NATIVE_FIRM\n");
+    }
+
+    printf("%-24s %-24s %8llu %8llu %10llu\n", "Total", "", (unsigned long long)total.commands, (unsigned long long)total.sectors,
+           (unsigned long long)total.sectors * 512);
+
+    return 0;
+}
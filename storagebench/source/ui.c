@@ -0,0 +1,54 @@
+/*
+*   This file is part of Luma3DS
+*   Copyright (C) 2016-2018 Aurora Wright, TuxSH
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/*
+*   The UI functions fs.c links against, for payloadMenu(). The benchmark never shows the menu.
+*/
+
+#include "draw.h"
+#include "screen.h"
+#include "utils.h"
+#include "buttons.h"
+
+u32 drawString(__attribute__((unused)) bool isTopScreen, u32 posX, __attribute__((unused)) u32 posY,
+               __attribute__((unused)) u32 color, __attribute__((unused)) const char *string)
+{
+    return posX;
+}
+
+void initScreens(void)
+{
+}
+
+u32 waitInput(__attribute__((unused)) bool isMenu)
+{
+    //Take the highlighted payload, START would poll HID_PAD
+    return BUTTON_A;
+}
+
+void wait(__attribute__((unused)) u64 amount)
+{
+}
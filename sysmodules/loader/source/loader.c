@@ -7,6 +7,7 @@
 #include "fsreg.h"
 #include "pxipm.h"
 #include "srvsys.h"
+#include "lzss.h"
 
 #define MAX_SESSIONS    1
 #define HBLDR_3DSX_TID  (*(vu64 *)0x1FF81100)
@@ -55,70 +56,24 @@ static inline void loadCFWInfo(void)
     if(needToInitSd) fileOpen(&file, ARCHIVE_SDMC, "/", FS_OPEN_READ); //Init SD card if SAFE_MODE is being booted 
 }
 
-static int lzss_decompress(u8 *end)
+static Result read_compressed_code(IFile *file, u8 *code, u32 size, u32 max_size)
 {
-  unsigned int v1; // r1@2
-  u8 *v2; // r2@2
-  u8 *v3; // r3@2
-  u8 *v4; // r1@2
-  char v5; // r5@4
-  char v6; // t1@4
-  signed int v7; // r6@4
-  int v9; // t1@7
-  u8 *v11; // r3@8
-  int v12; // r12@8
-  int v13; // t1@8
-  int v14; // t1@8
-  unsigned int v15; // r7@8
-  int v16; // r12@8
-  int ret;
+  u64 total;
+  Result res;
 
-  ret = 0;
-  if ( end )
+  // a single read: every FS read is an IPC round trip
+  res = IFile_Read(file, &total, code, size);
+  if (R_FAILED(res) || total != size)
   {
-    v1 = *((u32 *)end - 2);
-    v2 = &end[*((u32 *)end - 1)];
-    v3 = &end[-(v1 >> 24)];
-    v4 = &end[-(v1 & 0xFFFFFF)];
-    while ( v3 > v4 )
-    {
-      v6 = *(v3-- - 1);
-      v5 = v6;
-      v7 = 8;
-      while ( 1 )
-      {
-        if ( (v7-- < 1) )
-          break;
-        if ( v5 & 0x80 )
-        {
-          v13 = *(v3 - 1);
-          v11 = v3 - 1;
-          v12 = v13;
-          v14 = *(v11 - 1);
-          v3 = v11 - 1;
-          v15 = ((v14 | (v12 << 8)) & 0xFFFF0FFF) + 2;
-          v16 = v12 + 32;
-          do
-          {
-            ret = v2[v15];
-            *(v2-- - 1) = ret;
-            v16 -= 16;
-          }
-          while ( !(v16 < 0) );
-        }
-        else
-        {
-          v9 = *(v3-- - 1);
-          ret = v9;
-          *(v2-- - 1) = v9;
-        }
-        v5 *= 2;
-        if ( v3 <= v4 )
-          return ret;
-      }
-    }
+    svcBreak(USERBREAK_ASSERT);
   }
-  return ret;
+
+  if (!Lzss_Decompress(code, size, max_size))
+  {
+    return 0xC900464F;
+  }
+
+  return 0;
 }
 
 static Result allocate_shared_mem(prog_addrs_t *shared, prog_addrs_t *vaddr, int flags)
@@ -132,7 +87,7 @@ static Result allocate_shared_mem(prog_addrs_t *shared, prog_addrs_t *vaddr, int
   return svcControlMemory(&dummy, shared->text_addr, 0, shared->total_size << 12, (flags & 0xF00) | MEMOP_ALLOC, MEMPERM_READ | MEMPERM_WRITE);
 }
 
-static Result load_code(u64 progid, prog_addrs_t *shared, u64 prog_handle, int is_compressed)
+static Result load_code(u64 progid, prog_addrs_t *shared, u64 prog_handle, int is_compressed, int flags)
 {
   IFile file;
   FS_Path archivePath;
@@ -169,25 +124,31 @@ static Result load_code(u64 progid, prog_addrs_t *shared, u64 prog_handle, int i
         return 0xC900464F;
     }
 
-    // read code
-    res = IFile_Read(&file, &total, (void *)shared->text_addr, size);
-    IFile_Close(&file); // done reading
-    if (R_FAILED(res))
+    // read and decompress code
+    if (is_compressed)
     {
-        svcBreak(USERBREAK_ASSERT);
+        res = read_compressed_code(&file, (u8 *)shared->text_addr, size, shared->total_size << 12);
+        IFile_Close(&file); // done reading
+        if (R_FAILED(res))
+        {
+            return res;
+        }
     }
-
-    // decompress
-    if (is_compressed)
+    else
     {
-      lzss_decompress((u8 *)shared->text_addr + size);
+        res = IFile_Read(&file, &total, (void *)shared->text_addr, size);
+        IFile_Close(&file); // done reading
+        if (R_FAILED(res))
+        {
+            svcBreak(USERBREAK_ASSERT);
+        }
     }
   }
 
   u16 progver = g_exheader.codesetinfo.flags.remasterversion[0] | (g_exheader.codesetinfo.flags.remasterversion[1] << 8);
 
   // patch
-  patchCode(progid, progver, (u8 *)shared->text_addr, shared->total_size << 12, g_exheader.codesetinfo.text.codesize, g_exheader.codesetinfo.ro.codesize, g_exheader.codesetinfo.data.codesize, g_exheader.codesetinfo.ro.address, g_exheader.codesetinfo.data.address);
+  patchCode(progid, progver, (u8 *)shared->text_addr, shared->total_size << 12, g_exheader.codesetinfo.text.codesize, g_exheader.codesetinfo.ro.codesize, g_exheader.codesetinfo.data.codesize, g_exheader.codesetinfo.ro.address, g_exheader.codesetinfo.data.address, flags & 0xF00);
 
   return 0;
 }
@@ -363,7 +324,7 @@ static Result loader_LoadProcess(Handle *process, u64 prog_handle)
   }
 
   // load code
-  if ((res = load_code(progid, &shared_addr, prog_handle, g_exheader.codesetinfo.flags.flag & 1)) >= 0)
+  if ((res = load_code(progid, &shared_addr, prog_handle, g_exheader.codesetinfo.flags.flag & 1, flags)) >= 0)
   {
     memcpy(&codesetinfo.name, g_exheader.codesetinfo.name, 8);
     codesetinfo.program_id = progid;
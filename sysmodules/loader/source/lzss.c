@@ -0,0 +1,81 @@
+#include <3ds.h>
+#include "lzss.h"
+
+typedef struct __attribute__((packed))
+{
+    u32 val;
+} UnalignedU32;
+
+static inline u32 readUnaligned32(const u8 *addr)
+{
+    return ((const UnalignedU32 *)addr)->val;
+}
+
+static inline void writeUnaligned32(u8 *addr, u32 val)
+{
+    ((UnalignedU32 *)addr)->val = val;
+}
+
+bool Lzss_Decompress(u8 *buf, u32 compressedSize, u32 bufSize)
+{
+    if(compressedSize < 8 || compressedSize > bufSize) return false;
+
+    u8 *end = buf + compressedSize;
+    u32 footer = readUnaligned32(end - 8),
+        additionalSize = readUnaligned32(end - 4),
+        footerSize = footer >> 24,
+        streamSize = footer & 0xFFFFFF;
+
+    //The footer is part of the compressed stream and the output can't go past the buffer
+    if(footerSize < 8 || footerSize > streamSize || streamSize > compressedSize ||
+       additionalSize > bufSize - compressedSize) return false;
+
+    //Both the input and the output are walked backwards, the output is written in place above the input
+    u8 *in = end - footerSize,
+       *inEnd = end - streamSize,
+       *outEnd = end + additionalSize,
+       *out = outEnd;
+
+    while(in > inEnd)
+    {
+        u8 flags = *--in;
+
+        for(u32 i = 0; i < 8 && in > inEnd; i++, flags <<= 1)
+        {
+            if(flags & 0x80)
+            {
+                //The stream can't end in the middle of a back-reference
+                if(in - 2 < inEnd) return false;
+
+                u32 hi = in[-1],
+                    lo = in[-2],
+                    distance = (((hi << 8) | lo) & 0xFFF) + 3,
+                    count = (hi >> 4) + 3;
+
+                //Don't read past the decompressed data nor overwrite compressed data which hasn't been read yet
+                if(distance > (u32)(outEnd - out) || count > (u32)(out - (in - 2))) return false;
+
+                in -= 2;
+
+                //Copy 4 bytes at a time when the chunk doesn't overlap its source
+                if(distance >= 4)
+                {
+                    for(; count >= 4; count -= 4)
+                    {
+                        out -= 4;
+                        writeUnaligned32(out, readUnaligned32(out + distance));
+                    }
+                }
+
+                for(; count != 0; count--)
+                {
+                    out--;
+                    *out = out[distance];
+                }
+            }
+            else *--out = *--in;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <3ds/types.h>
+
+//Decompresses a reverse LZSS .code in place, returns false if it is malformed or doesn't fit in bufSize
+bool Lzss_Decompress(u8 *buf, u32 compressedSize, u32 bufSize);
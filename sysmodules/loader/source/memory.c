@@ -1,57 +1,62 @@
 #include "memory.h"
 
-void memcpy(void *dest, const void *src, u32 size)
+//Set Horspool: one shift table built over the shortest pattern, every pattern checked on a last byte hit
+void memsearchMulti(u8 *startPos, u32 size, Pattern *patterns, u32 nbPatterns)
 {
-    u8 *destc = (u8 *)dest;
-    const u8 *srcc = (const u8 *)src;
+    u32 minSize = 0xFFFFFFFF,
+        remaining = 0;
 
-    for(u32 i = 0; i < size; i++)
-        destc[i] = srcc[i];
-}
-
-void memset32(void *dest, u32 filler, u32 size)
-{
-    u32 *dest32 = (u32 *)dest;
-
-    for(u32 i = 0; i < size / 4; i++)
-        dest32[i] = filler;
-}
-
-int memcmp(const void *buf1, const void *buf2, u32 size)
-{
-    const u8 *buf1c = (const u8 *)buf1,
-             *buf2c = (const u8 *)buf2;
-
-    for(u32 i = 0; i < size; i++)
+    for(u32 i = 0; i < nbPatterns; i++)
     {
-        int cmp = buf1c[i] - buf2c[i];
-        if(cmp != 0) return cmp;
+        patterns[i].nbMatches = 0;
+        if(patterns[i].maxMatches > PATTERN_MAX_MATCHES) patterns[i].maxMatches = PATTERN_MAX_MATCHES;
+        if(!patterns[i].maxMatches) continue;
+
+        if(patterns[i].size < minSize) minSize = patterns[i].size;
+        remaining += patterns[i].maxMatches;
     }
 
-    return 0;
-}
+    if(!remaining || !minSize || minSize > size) return;
 
-//Boyer-Moore Horspool algorithm, adapted from http://www-igm.univ-mlv.fr/~lecroq/string/node18.html#SECTION00180
-u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize)
-{
-    const u8 *patternc = (const u8 *)pattern;
     u32 table[256];
 
     //Preprocessing
     for(u32 i = 0; i < 256; i++)
-        table[i] = patternSize;
-    for(u32 i = 0; i < patternSize - 1; i++)
-        table[patternc[i]] = patternSize - i - 1;
+        table[i] = minSize;
+    for(u32 i = 0; i < nbPatterns; i++)
+    {
+        const u8 *patternc = (const u8 *)patterns[i].pattern;
+
+        if(!patterns[i].maxMatches) continue;
+
+        for(u32 j = 0; j < minSize - 1; j++)
+            if(table[patternc[j]] > minSize - j - 1) table[patternc[j]] = minSize - j - 1;
+    }
 
     //Searching
     u32 j = 0;
-    while(j <= size - patternSize)
+    while(remaining != 0 && j <= size - minSize)
     {
-        u8 c = startPos[j + patternSize - 1];
-        if(patternc[patternSize - 1] == c && memcmp(pattern, startPos + j, patternSize - 1) == 0)
-            return startPos + j;
+        u8 c = startPos[j + minSize - 1];
+
+        for(u32 i = 0; i < nbPatterns; i++)
+        {
+            Pattern *p = &patterns[i];
+            const u8 *patternc = (const u8 *)p->pattern;
+
+            if(p->nbMatches == p->maxMatches || patternc[minSize - 1] != c || j + p->size > size) continue;
+
+            //Matches of the same pattern don't overlap, like successive memsearch calls
+            if(p->nbMatches != 0 && startPos + j < p->matches[p->nbMatches - 1] + p->size) continue;
+
+            if(memcmp(patternc, startPos + j, minSize - 1) == 0 &&
+               memcmp(patternc + minSize, startPos + j + minSize, p->size - minSize) == 0)
+            {
+                p->matches[p->nbMatches++] = startPos + j;
+                remaining--;
+            }
+        }
+
         j += table[c];
     }
-
-    return NULL;
-}
\ No newline at end of file
+}
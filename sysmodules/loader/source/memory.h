@@ -1,8 +1,17 @@
 #pragma once
 
 #include <3ds/types.h>
+#include "../../../common/memfuncs.h"
 
-void memcpy(void *dest, const void *src, u32 size);
-void memset32(void *dest, u32 filler, u32 size);
-int memcmp(const void *buf1, const void *buf2, u32 size);
-u8 *memsearch(u8 *startPos, const void *pattern, u32 size, u32 patternSize);
\ No newline at end of file
+#define PATTERN_MAX_MATCHES 2
+
+typedef struct Pattern
+{
+    const void *pattern;
+    u32 size;
+    u32 maxMatches;
+    u32 nbMatches;
+    u8 *matches[PATTERN_MAX_MATCHES];
+} Pattern;
+
+void memsearchMulti(u8 *startPos, u32 size, Pattern *patterns, u32 nbPatterns);
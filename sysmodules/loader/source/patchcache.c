@@ -0,0 +1,75 @@
+#include <3ds.h>
+#include "patchcache.h"
+#include "patcher.h"
+
+/* Locations found by the .text scans of patchCode() are kept in a small table on the SD card, one slot per title,
+   so that relaunching the same title version only has to spot-check them */
+
+#define PATCH_CACHE_PATH        "/luma/loadercache.bin"
+#define PATCH_CACHE_MAGIC       0x3143504C //"LPC1"
+#define PATCH_CACHE_NB_SLOTS    64
+#define PATCH_CACHE_NB_SAMPLES  1024
+
+static inline u32 getSlotOffset(u64 progId)
+{
+    return (u32)(((progId >> 8) ^ progId) % PATCH_CACHE_NB_SLOTS) * sizeof(PatchCacheEntry);
+}
+
+//Cheap fingerprint of .text made from evenly spaced words, hashing the whole section would cost as much as scanning it
+static u32 hashText(const u8 *code, u32 textSize)
+{
+    u32 stride = (textSize / PATCH_CACHE_NB_SAMPLES) & ~3,
+        hash = 2166136261;
+
+    if(stride == 0) stride = 4;
+
+    for(u32 pos = 0; pos + 4 <= textSize; pos += stride)
+        hash = (hash ^ *(const u32 *)(code + pos)) * 16777619;
+
+    return hash;
+}
+
+/* codePatchId identifies the code.ips/code.bps applied to .text before the scans (0 if none): patch files tend to
+   write to the same padding and function areas the scans pick, which the sampled words can't be relied on to cover */
+bool PatchCache_Load(PatchCacheEntry *entry, u64 progId, u16 progVer, const u8 *code, u32 textSize, u32 codePatchId)
+{
+    PatchCacheEntry stored;
+    IFile file;
+    u64 total;
+    bool ret = false;
+
+    memset32(entry, 0, sizeof(PatchCacheEntry));
+    entry->magic = PATCH_CACHE_MAGIC;
+    entry->progVer = progVer;
+    entry->progId = progId;
+    entry->textSize = textSize;
+    entry->textHash = hashText(code, textSize) ^ codePatchId;
+
+    if(!isSdMode || R_FAILED(fileOpen(&file, ARCHIVE_SDMC, PATCH_CACHE_PATH, FS_OPEN_READ))) return false;
+
+    file.pos = getSlotOffset(progId);
+
+    if(R_SUCCEEDED(IFile_Read(&file, &total, &stored, sizeof(PatchCacheEntry))) && total == sizeof(PatchCacheEntry) &&
+       stored.magic == entry->magic && stored.progVer == entry->progVer && stored.progId == entry->progId &&
+       stored.textSize == entry->textSize && stored.textHash == entry->textHash)
+    {
+        memcpy(entry, &stored, sizeof(PatchCacheEntry));
+        ret = true;
+    }
+
+    IFile_Close(&file);
+
+    return ret;
+}
+
+void PatchCache_Store(const PatchCacheEntry *entry)
+{
+    IFile file;
+    u32 written;
+
+    if(!isSdMode || R_FAILED(fileOpen(&file, ARCHIVE_SDMC, PATCH_CACHE_PATH, FS_OPEN_READ | FS_OPEN_WRITE | FS_OPEN_CREATE))) return;
+
+    FSFILE_Write(file.handle, &written, getSlotOffset(entry->progId), entry, sizeof(PatchCacheEntry), FS_WRITE_FLUSH);
+
+    IFile_Close(&file);
+}
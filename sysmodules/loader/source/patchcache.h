@@ -0,0 +1,23 @@
+#pragma once
+
+#include <3ds/types.h>
+#include "memory.h"
+
+#define PATCH_CACHE_MAX_PATTERNS    4
+#define PATCH_CACHE_MAX_VALUES      13
+
+typedef struct PatchCacheEntry
+{
+    u32 magic;
+    u16 progVer;
+    u16 reserved;
+    u64 progId;
+    u32 textSize;
+    u32 textHash;
+    u32 nbMatches[PATCH_CACHE_MAX_PATTERNS];
+    u32 matches[PATCH_CACHE_MAX_PATTERNS][PATTERN_MAX_MATCHES];
+    u32 values[PATCH_CACHE_MAX_VALUES];
+} PatchCacheEntry;
+
+bool PatchCache_Load(PatchCacheEntry *entry, u64 progId, u16 progVer, const u8 *code, u32 textSize, u32 codePatchId);
+void PatchCache_Store(const PatchCacheEntry *entry);
@@ -3,6 +3,7 @@
 #include "memory.h"
 #include "strings.h"
 #include "fsldr.h"
+#include "patchcache.h"
 #include "../build/bundled.h"
 
 static u32 patchMemory(u8 *start, u32 size, const void *pattern, u32 patSize, s32 offset, const void *replace, u32 repSize, u32 count)
@@ -28,6 +29,73 @@ static u32 patchMemory(u8 *start, u32 size, const void *pattern, u32 patSize, s3
     return i;
 }
 
+static inline bool isMatchIntact(const Pattern *pattern)
+{
+    for(u32 i = 0; i < pattern->nbMatches; i++)
+        if(memcmp(pattern->matches[i], pattern->pattern, pattern->size) != 0) return false;
+
+    return true;
+}
+
+static u8 *getFirstMatch(u8 *start, u32 size, const Pattern *pattern)
+{
+    //A patch applied after the sweep may have overwritten the match, search the patched code again in that case
+    if(!isMatchIntact(pattern)) return memsearch(start, pattern->pattern, size, pattern->size);
+
+    return pattern->nbMatches != 0 ? pattern->matches[0] : NULL;
+}
+
+static u32 patchMatches(u8 *start, u32 size, const Pattern *pattern, s32 offset, const void *replace, u32 repSize)
+{
+    if(!isMatchIntact(pattern))
+        return patchMemory(start, size, pattern->pattern, pattern->size, offset, replace, repSize, pattern->maxMatches);
+
+    for(u32 i = 0; i < pattern->nbMatches; i++)
+        memcpy(pattern->matches[i] + offset, replace, repSize);
+
+    return pattern->nbMatches;
+}
+
+//Takes the pattern locations from the patch cache when they still hold the patterns, scans .text otherwise
+static bool findPatterns(PatchCacheEntry *cache, u64 progId, u16 progVer, u8 *code, u32 textSize, Pattern *patterns, u32 nbPatterns)
+{
+    if(PatchCache_Load(cache, progId, progVer, code, textSize, 0))
+    {
+        u32 i;
+
+        for(i = 0; i < nbPatterns; i++)
+        {
+            Pattern *p = &patterns[i];
+
+            //The pattern may have been disabled when the entry was made
+            if(cache->nbMatches[i] < p->maxMatches) break;
+
+            for(p->nbMatches = 0; p->nbMatches < p->maxMatches; p->nbMatches++)
+            {
+                u32 offset = cache->matches[i][p->nbMatches];
+
+                if(offset > textSize - p->size || memcmp(code + offset, p->pattern, p->size) != 0) break;
+                p->matches[p->nbMatches] = code + offset;
+            }
+
+            if(p->nbMatches != p->maxMatches) break;
+        }
+
+        if(i == nbPatterns) return true;
+    }
+
+    memsearchMulti(code, textSize, patterns, nbPatterns);
+
+    for(u32 i = 0; i < nbPatterns; i++)
+    {
+        cache->nbMatches[i] = patterns[i].nbMatches;
+        for(u32 j = 0; j < patterns[i].nbMatches; j++)
+            cache->matches[i][j] = (u32)(patterns[i].matches[j] - code);
+    }
+
+    return false;
+}
+
 Result fileOpen(IFile *file, FS_ArchiveID archiveId, const char *path, int flags)
 {
     FS_Path filePath = {PATH_ASCII, strnlen(path, 255) + 1, path},
@@ -141,6 +209,14 @@ exit:
     IFile_Close(&file);
 }
 
+static inline bool isManualRegionCheck(u8 *code, u32 textSize, u32 pos)
+{
+    u32 *code32 = (u32 *)(code + pos);
+
+    return pos >= 4 && pos < textSize && (pos & 3) == 0 &&
+           code32[1] == 0xE1A0000D && (*code32 & 0xFFFFFF00) == 0x0A000000 && (code32[-1] & 0xFFFFFF00) == 0xE1110000;
+}
+
 static u32 findFunctionStart(u8 *code, u32 pos)
 {
     while(pos >= 4)
@@ -264,61 +340,294 @@ static inline bool findLayeredFsPayloadOffset(u8 *code, u32 size, u32 roSize, u3
     return *payloadOffset != 0 && *pathOffset != 0;
 }
 
-static inline bool applyCodeIpsPatch(u64 progId, u8 *code, u32 size)
+#define PATCH_BUFFER_SIZE   0x4000
+#define BPS_SOURCE_ADDRESS  0x0D000000
+
+typedef struct PatchFile
+{
+    IFile file;
+    u64 size;
+    u64 offset;
+    u32 bufPos;
+    u32 bufSize;
+    u32 crc;
+    bool computeCrc;
+} PatchFile;
+
+static u8 patchBuffer[PATCH_BUFFER_SIZE];
+static u32 codePatchId; //Identifies the last code patch applied, part of the layeredFs patch cache key
+
+static u32 updateCrc32(u32 crc, const u8 *data, u32 size)
 {
-    /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/code.ips"
-       If it exists it should be an IPS format patch */
+    static u32 table[256];
 
-    char path[] = "/luma/titles/0000000000000000/code.ips";
-    progIdToStr(path + 28, progId);
+    if(!table[1])
+    {
+        for(u32 i = 0; i < 256; i++)
+        {
+            u32 c = i;
+            for(u32 j = 0; j < 8; j++)
+                c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+            table[i] = c;
+        }
+    }
 
-    IFile file;
+    for(u32 i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
 
-    if(!openLumaFile(&file, path)) return true;
+    return crc;
+}
 
-    bool ret = false;
-    u8 buffer[5];
-    u64 total;
+//Every FS read is an IPC round trip, so the patch is read in large chunks and parsed from memory
+static bool readPatchFile(PatchFile *patch, void *dst, u32 len)
+{
+    u8 *dstc = (u8 *)dst;
 
-    if(R_FAILED(IFile_Read(&file, &total, buffer, 5)) || total != 5 || memcmp(buffer, "PATCH", 5) != 0) goto exit;
+    if(len > patch->size - patch->offset) return false;
 
-    while(R_SUCCEEDED(IFile_Read(&file, &total, buffer, 3)) && total == 3)
+    while(len != 0)
     {
-        if(memcmp(buffer, "EOF", 3) == 0)
+        u64 total;
+        u32 n;
+
+        if(patch->bufPos == patch->bufSize)
         {
-            ret = true;
-            break;
+            u64 left = patch->size - patch->file.pos;
+
+            //Big chunks (IPS records, BPS TargetRead) are read directly to their destination
+            if(len >= PATCH_BUFFER_SIZE)
+            {
+                if(R_FAILED(IFile_Read(&patch->file, &total, dstc, len)) || total != len) return false;
+                n = len;
+            }
+            else
+            {
+                u32 toRead = left > PATCH_BUFFER_SIZE ? PATCH_BUFFER_SIZE : (u32)left;
+
+                if(R_FAILED(IFile_Read(&patch->file, &total, patchBuffer, toRead)) || total != toRead) return false;
+                patch->bufPos = 0;
+                patch->bufSize = toRead;
+                continue;
+            }
+        }
+        else
+        {
+            n = patch->bufSize - patch->bufPos;
+            if(n > len) n = len;
+            memcpy(dstc, patchBuffer + patch->bufPos, n);
+            patch->bufPos += n;
         }
 
+        if(patch->computeCrc) patch->crc = updateCrc32(patch->crc, dstc, n);
+
+        dstc += n;
+        len -= n;
+        patch->offset += n;
+    }
+
+    return true;
+}
+
+static bool applyIpsPatch(PatchFile *patch, u8 *code, u32 size)
+{
+    u8 buffer[5];
+
+    if(!readPatchFile(patch, buffer, 5) || memcmp(buffer, "PATCH", 5) != 0) return false;
+
+    while(readPatchFile(patch, buffer, 3))
+    {
+        if(memcmp(buffer, "EOF", 3) == 0) return true;
+
         u32 offset = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
 
-        if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+        if(!readPatchFile(patch, buffer, 2)) break;
 
         u32 patchSize = (buffer[0] << 8) | buffer[1];
 
         if(!patchSize)
         {
-            if(R_FAILED(IFile_Read(&file, &total, buffer, 2)) || total != 2) break;
+            if(!readPatchFile(patch, buffer, 3)) break;
 
             u32 rleSize = (buffer[0] << 8) | buffer[1];
 
             if(offset + rleSize > size) break;
 
-            if(R_FAILED(IFile_Read(&file, &total, buffer, 1)) || total != 1) break;
-
             for(u32 i = 0; i < rleSize; i++)
-                code[offset + i] = buffer[0];
+                code[offset + i] = buffer[2];
 
             continue;
         }
 
-        if(offset + patchSize > size) break;
+        if(offset + patchSize > size || !readPatchFile(patch, code + offset, patchSize)) break;
+    }
+
+    return false;
+}
+
+static bool readBpsNumber(PatchFile *patch, u32 *out)
+{
+    u64 data = 0,
+        shift = 1;
+
+    while(true)
+    {
+        u8 x;
 
-        if(R_FAILED(IFile_Read(&file, &total, code + offset, patchSize)) || total != patchSize) break;
+        if(!readPatchFile(patch, &x, 1)) return false;
+
+        data += (x & 0x7F) * shift;
+        if(x & 0x80) break;
+        shift <<= 7;
+        data += shift;
+
+        if(data > 0xFFFFFFFF) return false;
     }
 
+    if(data > 0xFFFFFFFF) return false;
+
+    *out = (u32)data;
+
+    return true;
+}
+
+static bool applyBpsPatch(PatchFile *patch, u8 *code, u32 size, u32 memRegion)
+{
+    u8 buffer[12];
+    u32 sourceSize,
+        targetSize,
+        metadataSize;
+
+    if(patch->size < 4 + 3 + 12 || !readPatchFile(patch, buffer, 4) || memcmp(buffer, "BPS1", 4) != 0 ||
+       !readBpsNumber(patch, &sourceSize) || !readBpsNumber(patch, &targetSize) || !readBpsNumber(patch, &metadataSize) ||
+       sourceSize > size || targetSize > size) return false;
+
+    //Skip the metadata
+    for(u32 left = metadataSize, n; left != 0; left -= n)
+    {
+        n = left > sizeof(buffer) ? sizeof(buffer) : left;
+        if(!readPatchFile(patch, buffer, n)) return false;
+    }
+
+    /* The target is written in place, so the source needs to be kept around. The copy covers the target too, so that
+       a failed patch can be undone. It's allocated from the title's memory region, which its code was loaded to */
+    u32 savedSize = sourceSize > targetSize ? sourceSize : targetSize,
+        sourceAllocSize = (savedSize + 0xFFF) & ~0xFFF,
+        dummy;
+    u8 *source = (u8 *)BPS_SOURCE_ADDRESS;
+
+    if(sourceAllocSize != 0 && R_FAILED(svcControlMemory(&dummy, BPS_SOURCE_ADDRESS, 0, sourceAllocSize, memRegion | MEMOP_ALLOC, MEMPERM_READ | MEMPERM_WRITE)))
+        svcBreak(USERBREAK_PANIC); //Not the patch's fault, don't report it as malformed
+
+    memcpy(source, code, savedSize);
+
+    bool ret = false;
+    u32 outputOffset = 0,
+        sourceRelativeOffset = 0,
+        targetRelativeOffset = 0;
+
+    while(patch->offset < patch->size - 12)
+    {
+        u32 data;
+
+        if(!readBpsNumber(patch, &data)) goto exit;
+
+        u32 command = data & 3,
+            length = (data >> 2) + 1;
+
+        if(length > targetSize - outputOffset) goto exit;
+
+        switch(command)
+        {
+            case 0: //SourceRead
+                if(outputOffset + length > sourceSize) goto exit;
+                memcpy(code + outputOffset, source + outputOffset, length);
+                break;
+            case 1: //TargetRead
+                if(!readPatchFile(patch, code + outputOffset, length)) goto exit;
+                break;
+            default:
+            {
+                u32 offsetData;
+
+                if(!readBpsNumber(patch, &offsetData)) goto exit;
+
+                u32 offset = (offsetData & 1) ? -(offsetData >> 1) : offsetData >> 1;
+
+                if(command == 2) //SourceCopy
+                {
+                    sourceRelativeOffset += offset;
+                    if(sourceRelativeOffset > sourceSize || length > sourceSize - sourceRelativeOffset) goto exit;
+                    memcpy(code + outputOffset, source + sourceRelativeOffset, length);
+                    sourceRelativeOffset += length;
+                }
+                else //TargetCopy, can overlap the output
+                {
+                    targetRelativeOffset += offset;
+                    if(targetRelativeOffset >= outputOffset) goto exit;
+                    for(u32 i = 0; i < length; i++)
+                        code[outputOffset + i] = code[targetRelativeOffset + i];
+                    targetRelativeOffset += length;
+                }
+                break;
+            }
+        }
+
+        outputOffset += length;
+    }
+
+    if(outputOffset != targetSize || !readPatchFile(patch, buffer, 8)) goto exit;
+
+    u32 patchCrc = ~patch->crc;
+
+    if(!readPatchFile(patch, buffer + 8, 4)) goto exit;
+
+    u32 crcs[3];
+    memcpy(crcs, buffer, sizeof(crcs));
+
+    ret = crcs[0] == ~updateCrc32(0xFFFFFFFF, source, sourceSize) &&
+          crcs[1] == ~updateCrc32(0xFFFFFFFF, code, targetSize) &&
+          crcs[2] == patchCrc;
+
 exit:
-    IFile_Close(&file);
+    //Don't leave a half-patched binary behind
+    if(!ret) memcpy(code, source, savedSize);
+
+    if(sourceAllocSize != 0) svcControlMemory(&dummy, BPS_SOURCE_ADDRESS, 0, sourceAllocSize, MEMOP_FREE, 0);
+
+    return ret;
+}
+
+static inline bool applyCodePatch(u64 progId, u8 *code, u32 size, u32 memRegion)
+{
+    /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/code.ips" or "code.bps"
+       If it exists it should be an IPS or BPS format patch */
+
+    char path[] = "/luma/titles/0000000000000000/code.ips";
+    progIdToStr(path + 28, progId);
+
+    PatchFile patch;
+    bool isBps = false;
+
+    codePatchId = 0;
+
+    if(!openLumaFile(&patch.file, path))
+    {
+        memcpy(path + 35, "bps", 3);
+        if(!openLumaFile(&patch.file, path)) return true;
+        isBps = true;
+    }
+
+    patch.offset = 0;
+    patch.bufPos = patch.bufSize = 0;
+    patch.crc = 0xFFFFFFFF;
+    patch.computeCrc = true; //IPS patches too, for codePatchId
+
+    bool ret = R_SUCCEEDED(IFile_GetSize(&patch.file, &patch.size)) &&
+               (isBps ? applyBpsPatch(&patch, code, size, memRegion) : applyIpsPatch(&patch, code, size));
+
+    codePatchId = (~patch.crc ^ (u32)patch.size) | 1;
+
+    IFile_Close(&patch.file);
 
     return ret;
 }
@@ -486,7 +795,58 @@ exit:
     return ret;
 }
 
-static inline bool patchLayeredFs(u64 progId, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
+/* The symbols are spot-checked against the instruction found at each of them when the entry was made. The payload and
+   path locations must still be what findLayeredFsPayloadOffset() would pick (padding, or the start of a function),
+   and the update RomFS mount string must still be where it was found */
+static inline bool isLayeredFsCacheValid(const PatchCacheEntry *cache, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize,
+                                         const char **updateRomFsMounts, u32 nbUpdateRomFsMounts)
+{
+    u32 roundedTextSize = ((textSize + 4095) & 0xFFFFF000),
+        roundedRoSize = ((roSize + 4095) & 0xFFFFF000),
+        roundedDataSize = ((dataSize + 4095) & 0xFFFFF000),
+        payloadOffset = cache->values[4],
+        pathOffset = cache->values[5];
+
+    for(u32 i = 0; i < 4; i++)
+    {
+        u32 offset = cache->values[i];
+
+        if(offset > textSize - 4 || (offset & 3) != 0 || *(u16 *)(code + offset + 2) != 0xE92D ||
+           *(u32 *)(code + offset) != cache->values[8 + i]) return false;
+    }
+
+    if(roundedTextSize - textSize >= romfsredir_bin_size)
+    {
+        if(payloadOffset != textSize) return false;
+    }
+    else if(payloadOffset == 0 || payloadOffset > textSize - romfsredir_bin_size || (payloadOffset & 3) != 0 ||
+            *(u16 *)(code + payloadOffset + 2) != 0xE92D) return false;
+
+    if(roundedRoSize - roSize >= 39)
+    {
+        if(pathOffset != roundedTextSize + roSize) return false;
+    }
+    else if(roundedDataSize - dataSize >= 39)
+    {
+        if(pathOffset != roundedTextSize + roundedRoSize + dataSize) return false;
+    }
+    else if(pathOffset == 0 || pathOffset > textSize - 4 || (pathOffset & 3) != 0 || *(u16 *)(code + pathOffset + 2) != 0xE92D ||
+            cache->values[6] != 0x100000 + pathOffset) return false;
+
+    //The last mount is the fallback, it isn't searched for
+    u32 index = cache->values[7],
+        mountOffset = cache->values[12];
+
+    if(index >= nbUpdateRomFsMounts) return false;
+    if(index == nbUpdateRomFsMounts - 1) return true;
+
+    u32 mountSize = strnlen(updateRomFsMounts[index], 255);
+
+    return mountOffset != 0 && mountOffset <= size - mountSize && code[mountOffset - 1] == 0 &&
+           memcmp(code + mountOffset, updateRomFsMounts[index], mountSize) == 0;
+}
+
+static inline bool patchLayeredFs(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
 {
     /* Here we look for "/luma/titles/[u64 titleID in hex, uppercase]/romfs"
        If it exists it should be a folder containing ROMFS files */
@@ -498,32 +858,73 @@ static inline bool patchLayeredFs(u64 progId, u8 *code, u32 size, u32 textSize,
 
     if(!archiveId) return true;
 
-    u32 fsMountArchive = 0xFFFFFFFF,
-        fsRegisterArchive = 0xFFFFFFFF,
-        fsTryOpenFile = 0xFFFFFFFF,
-        fsOpenFileDirectly = 0xFFFFFFFF,
-        payloadOffset = 0,
-        pathOffset = 0,
-        pathAddress;
-
-    if(!findLayeredFsSymbols(code, textSize, &fsMountArchive, &fsRegisterArchive, &fsTryOpenFile, &fsOpenFileDirectly) ||
-       !findLayeredFsPayloadOffset(code, textSize, roSize, dataSize, roAddress, dataAddress, &payloadOffset, &pathOffset, &pathAddress)) return false;
-
     static const char *updateRomFsMounts[] = { "rom2:",
                                                "rex:",
                                                "patch:",
                                                "ext:",
                                                "rom:" };
-    u32 updateRomFsIndex;
+    const u32 nbUpdateRomFsMounts = sizeof(updateRomFsMounts) / sizeof(char *);
+
+    u32 fsMountArchive,
+        fsRegisterArchive,
+        fsTryOpenFile,
+        fsOpenFileDirectly,
+        payloadOffset,
+        pathOffset,
+        pathAddress,
+        updateRomFsIndex,
+        updateRomFsOffset = 0xFFFFFFFF;
 
-    //Locate update RomFSes
-    for(updateRomFsIndex = 0; updateRomFsIndex < sizeof(updateRomFsMounts) / sizeof(char *) - 1; updateRomFsIndex++)
+    PatchCacheEntry cache;
+
+    if(PatchCache_Load(&cache, progId, progVer, code, textSize, codePatchId) && isLayeredFsCacheValid(&cache, code, size, textSize, roSize, dataSize, updateRomFsMounts, nbUpdateRomFsMounts))
     {
-        u32 patternSize = strnlen(updateRomFsMounts[updateRomFsIndex], 255);
-        u8 temp[7];
-        temp[0] = 0;
-        memcpy(temp + 1, updateRomFsMounts[updateRomFsIndex], patternSize);
-        if(memsearch(code, temp, size, patternSize + 1) != NULL) break;
+        fsMountArchive = cache.values[0];
+        fsRegisterArchive = cache.values[1];
+        fsTryOpenFile = cache.values[2];
+        fsOpenFileDirectly = cache.values[3];
+        payloadOffset = cache.values[4];
+        pathOffset = cache.values[5];
+        pathAddress = cache.values[6];
+        updateRomFsIndex = cache.values[7];
+    }
+    else
+    {
+        fsMountArchive = fsRegisterArchive = fsTryOpenFile = fsOpenFileDirectly = 0xFFFFFFFF;
+        payloadOffset = pathOffset = 0;
+
+        if(!findLayeredFsSymbols(code, textSize, &fsMountArchive, &fsRegisterArchive, &fsTryOpenFile, &fsOpenFileDirectly) ||
+           !findLayeredFsPayloadOffset(code, textSize, roSize, dataSize, roAddress, dataAddress, &payloadOffset, &pathOffset, &pathAddress)) return false;
+
+        //Locate update RomFSes
+        for(updateRomFsIndex = 0; updateRomFsIndex < nbUpdateRomFsMounts - 1; updateRomFsIndex++)
+        {
+            u32 patternSize = strnlen(updateRomFsMounts[updateRomFsIndex], 255);
+            u8 temp[7];
+            temp[0] = 0;
+            memcpy(temp + 1, updateRomFsMounts[updateRomFsIndex], patternSize);
+
+            u8 *found = memsearch(code, temp, size, patternSize + 1);
+            if(found != NULL)
+            {
+                updateRomFsOffset = (u32)(found + 1 - code);
+                break;
+            }
+        }
+
+        cache.values[0] = fsMountArchive;
+        cache.values[1] = fsRegisterArchive;
+        cache.values[2] = fsTryOpenFile;
+        cache.values[3] = fsOpenFileDirectly;
+        cache.values[4] = payloadOffset;
+        cache.values[5] = pathOffset;
+        cache.values[6] = pathAddress;
+        cache.values[7] = updateRomFsIndex;
+        cache.values[12] = updateRomFsOffset;
+        for(u32 i = 0; i < 4; i++)
+            cache.values[8 + i] = *(u32 *)(code + cache.values[i]);
+
+        PatchCache_Store(&cache);
     }
 
     //Setup the payload
@@ -576,7 +977,7 @@ static inline bool patchLayeredFs(u64 progId, u8 *code, u32 size, u32 textSize,
     return true;
 }
 
-void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress)
+void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress, u32 memRegion)
 {
     if(progId == 0x0004003000008F02LL || //USA Home Menu
        progId == 0x0004003000008202LL || //JPN Home Menu
@@ -599,44 +1000,43 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
                 break;
         }
 
-        if(applyRegionFreePatch)
-        {
-            static const u8 pattern[] = {
-                0x0A, 0x0C, 0x00, 0x10
-            },
-                            patch[] = {
-                0x01, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1
-            };
+        static const u8 regionPattern[] = {
+            0x0A, 0x0C, 0x00, 0x10
+        },
+                        regionPatch[] = {
+            0x01, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1
+        },
+                        flashcartPattern[] = {
+            0x10, 0xD1, 0xE5, 0x08, 0x00, 0x8D
+        };
 
-            //Patch SMDH region check
-            if(!patchMemory(code, textSize,
-                    pattern,
-                    sizeof(pattern), -31,
-                    patch,
-                    sizeof(patch), 1
-                )) goto error;
-        }
+        Pattern patterns[] = {
+            {.pattern = regionPattern, .size = sizeof(regionPattern), .maxMatches = applyRegionFreePatch ? 1 : 0},
+            {.pattern = flashcartPattern, .size = sizeof(flashcartPattern), .maxMatches = 1}
+        };
+
+        //Locate all the signatures in a single pass, unless they're cached
+        PatchCacheEntry cache;
+        bool isCached = findPatterns(&cache, progId, progVer, code, textSize, patterns, sizeof(patterns) / sizeof(Pattern));
+
+        //Patch SMDH region check
+        if(applyRegionFreePatch && !patchMatches(code, textSize, &patterns[0], -31, regionPatch, sizeof(regionPatch))) goto error;
 
         //Patch SMDH region check for manuals
-        u32 i;
-        for(i = 4; i < textSize; i += 4)
+        u32 i = cache.values[0];
+        if(!isCached || !isManualRegionCheck(code, textSize, i))
         {
-            u32 *code32 = (u32 *)(code + i);
-            if(code32[1] == 0xE1A0000D && (*code32 & 0xFFFFFF00) == 0x0A000000 && (code32[-1] & 0xFFFFFF00) == 0xE1110000)
-                {
-                    *code32 = 0xE320F000;
-                    break;
-                }
+            isCached = false;
+            for(i = 4; i < textSize && !isManualRegionCheck(code, textSize, i); i += 4);
+            cache.values[0] = i;
         }
 
-        if(i == textSize) goto error;
+        if(i >= textSize) goto error;
 
-        //Patch DS flashcart whitelist check
-        static const u8 pattern[] = {
-            0x10, 0xD1, 0xE5, 0x08, 0x00, 0x8D
-        };
+        *(u32 *)(code + i) = 0xE320F000;
 
-        u8 *temp = memsearch(code, pattern, textSize, sizeof(pattern));
+        //Patch DS flashcart whitelist check
+        u8 *temp = getFirstMatch(code, textSize, &patterns[1]);
 
         if(temp == NULL) goto error;
 
@@ -648,6 +1048,8 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
 
         off[0] = 0xE3A00000; //mov r0, #0
         off[1] = 0xE12FFF1E; //bx lr
+
+        if(!isCached) PatchCache_Store(&cache);
     }
 
     else if((progId == 0x0004001000021000LL || //USA MSET
@@ -703,46 +1105,46 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
 
     else if(progId == 0x0004013000008002LL) //NS
     {
+        static const u8 cartPattern[] = {
+            0x0C, 0x18, 0xE1, 0xD8
+        },
+                        cartPatch[] = {
+            0x0B, 0x18, 0x21, 0xC8
+        },
+                        cpuPattern[] = {
+            0x0C, 0x00, 0x94, 0x15
+        };
+
+        u32 cpuSetting = isN3DS ? MULTICONFIG(NEWCPU) : 0;
+
+        Pattern patterns[] = {
+            {.pattern = cartPattern, .size = sizeof(cartPattern), .maxMatches = progVer > 4 ? 2 : 0},
+            {.pattern = cpuPattern, .size = sizeof(cpuPattern), .maxMatches = cpuSetting != 0 ? 1 : 0}
+        };
+
+        //Locate all the signatures in a single pass, unless they're cached
+        PatchCacheEntry cache;
+        bool isCached = findPatterns(&cache, progId, progVer, code, textSize, patterns, sizeof(patterns) / sizeof(Pattern));
+
         if(progVer > 4)
         {
-            static const u8 pattern[] = {
-                0x0C, 0x18, 0xE1, 0xD8
-            },
-                            patch[] = {
-                0x0B, 0x18, 0x21, 0xC8
-            };
-
             //Disable updates from foreign carts (makes carts region-free)
-            u32 ret = patchMemory(code, textSize,
-                          pattern,
-                          sizeof(pattern), 0,
-                          patch,
-                          sizeof(patch), 2
-                      );
+            u32 ret = patchMatches(code, textSize, &patterns[0], 0, cartPatch, sizeof(cartPatch));
 
             if(ret == 0 || (ret == 1 && progVer > 0xB)) goto error;
         }
 
-        if(isN3DS)
+        if(cpuSetting != 0)
         {
-            u32 cpuSetting = MULTICONFIG(NEWCPU);
+            u32 *off = (u32 *)getFirstMatch(code, textSize, &patterns[1]);
 
-            if(cpuSetting != 0)
-            {
-                static const u8 pattern[] = {
-                    0x0C, 0x00, 0x94, 0x15
-                };
-
-                u32 *off = (u32 *)memsearch(code, pattern, textSize, sizeof(pattern));
+            if(off == NULL) goto error;
 
-                if(off == NULL) goto error;
-
-                //Patch N3DS CPU Clock and L2 cache setting
-                *(off - 4) = *(off - 3);
-                *(off - 3) = *(off - 1);
-                memcpy(off - 1, off, 16);
-                *(off + 3) = 0xE3800000 | cpuSetting;
-            }
+            //Patch N3DS CPU Clock and L2 cache setting
+            *(off - 4) = *(off - 3);
+            *(off - 3) = *(off - 1);
+            memcpy(off - 1, off, 16);
+            *(off + 3) = 0xE3800000 | cpuSetting;
         }
 
         if(progVer > 0x12)
@@ -752,9 +1154,17 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
             };
 
             u8 *roStart = code + ((textSize + 4095) & 0xFFFFF000),
-               *start = memsearch(roStart, pattern, roSize, sizeof(pattern));
+               *start = roStart + cache.values[0];
 
-            if(start == NULL) goto error;
+            if(!isCached || cache.values[0] > roSize - sizeof(pattern) || memcmp(start, pattern, sizeof(pattern)) != 0)
+            {
+                isCached = false;
+                start = memsearch(roStart, pattern, roSize, sizeof(pattern));
+
+                if(start == NULL) goto error;
+
+                cache.values[0] = (u32)(start - roStart);
+            }
 
             start++;
             u8 *end;
@@ -771,9 +1181,19 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
         {
             // Makes ErrDisp to not start up
             static const u64 errDispTid = 0x0004003000008A02ULL;
-            u32 *errDispTidLoc = (u32 *)memsearch(code, &errDispTid, size, sizeof(errDispTid));
+            u32 *errDispTidLoc = (u32 *)(code + cache.values[1]);
+
+            if(!isCached || cache.values[1] > size - sizeof(errDispTid) || memcmp(errDispTidLoc, &errDispTid, sizeof(errDispTid)) != 0)
+            {
+                isCached = false;
+                errDispTidLoc = (u32 *)memsearch(code, &errDispTid, size, sizeof(errDispTid));
+                cache.values[1] = (u32)((u8 *)errDispTidLoc - code);
+            }
+
             *(errDispTidLoc - 6) = 0xE3A00000; // mov r0, #0
         }
+
+        if(!isCached) PatchCache_Store(&cache);
     }
 
     else if(progId == 0x0004013000001702LL) //CFG
@@ -823,25 +1243,22 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
             0x00, 0x00, 0xA0, 0xE3, 0x1E, 0xFF, 0x2F, 0xE1 //mov r0, #0; bx lr
         };
 
+        Pattern patterns[] = {
+            {.pattern = pattern, .size = sizeof(pattern), .maxMatches = 1},
+            {.pattern = pattern2, .size = sizeof(pattern2), .maxMatches = 1},
+            {.pattern = pattern3, .size = sizeof(pattern3), .maxMatches = 1}
+        };
+
+        //Locate all the signatures in a single pass, unless they're cached
+        PatchCacheEntry cache;
+        bool isCached = findPatterns(&cache, progId, progVer, code, textSize, patterns, sizeof(patterns) / sizeof(Pattern));
+
         //Disable CRR0 signature (RSA2048 with SHA256) check and CRO0/CRR0 SHA256 hash checks (section hashes, and hash table)
-        if(!patchMemory(code, textSize,
-                pattern,
-                sizeof(pattern), -9,
-                patch,
-                sizeof(patch), 1
-            ) ||
-           !patchMemory(code, textSize,
-                pattern2,
-                sizeof(pattern2), 1,
-                patch,
-                sizeof(patch), 1
-            ) ||
-           !patchMemory(code, textSize,
-                pattern3,
-                sizeof(pattern3), -2,
-                patch,
-                sizeof(patch), 1
-            )) goto error;
+        if(!patchMatches(code, textSize, &patterns[0], -9, patch, sizeof(patch)) ||
+           !patchMatches(code, textSize, &patterns[1], 1, patch, sizeof(patch)) ||
+           !patchMatches(code, textSize, &patterns[2], -2, patch, sizeof(patch))) goto error;
+
+        if(!isCached) PatchCache_Store(&cache);
     }
 
     else if(progId == 0x0004013000002802LL) //DLP
@@ -882,7 +1299,7 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
 
     if(CONFIG(PATCHGAMES))
     {
-        if(!applyCodeIpsPatch(progId, code, size)) goto error;
+        if(!applyCodePatch(progId, code, size, memRegion)) goto error;
 
         if((u32)((progId >> 0x20) & 0xFFFFFFEDULL) == 0x00040000)
         {
@@ -894,7 +1311,7 @@ void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 ro
 
             if(loadTitleLocaleConfig(progId, &mask, &regionId, &languageId, &countryId, &stateId))
                 svcKernelSetState(0x10001, ((u32)stateId << 24) | ((u32)countryId << 16) | ((u32)languageId << 8) | ((u32)regionId << 4) | (u32)mask , progId);
-            if(!patchLayeredFs(progId, code, size, textSize, roSize, dataSize, roAddress, dataAddress)) goto error;
+            if(!patchLayeredFs(progId, progVer, code, size, textSize, roSize, dataSize, roAddress, dataAddress)) goto error;
         }
     }
 
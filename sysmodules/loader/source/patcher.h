@@ -41,7 +41,7 @@ enum singleOptions
 extern u32 config, multiConfig, bootConfig;
 extern bool isN3DS, needToInitSd, isSdMode; 
 
-void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress);
+void patchCode(u64 progId, u16 progVer, u8 *code, u32 size, u32 textSize, u32 roSize, u32 dataSize, u32 roAddress, u32 dataAddress, u32 memRegion);
 Result fileOpen(IFile *file, FS_ArchiveID archiveId, const char *path, int flags);
 bool loadTitleCodeSection(u64 progId, u8 *code, u32 size);
 bool loadTitleExheader(u64 progId, exheader_header *exheader);
@@ -46,10 +46,17 @@ void PXISendWord(u32 word)
 
 void PXISendBuffer(const u32 *buffer, u32 nbWords)
 {
-    for(; nbWords > 0; nbWords--)
+    while(nbWords > 0)
     {
-        while(REG_PXI_CNT & CNT_SEND_FIFO_FULL_STATUS);
-        REG_PXI_SEND = *buffer++;
+        // An empty FIFO takes a whole burst without polling the status for each word
+        u32 n = (REG_PXI_CNT & CNT_SEND_FIFO_EMPTY_STATUS) ? PXI_FIFO_DEPTH : 1;
+        n = n < nbWords ? n : nbWords;
+
+        if(n == 1)
+            while(REG_PXI_CNT & CNT_SEND_FIFO_FULL_STATUS);
+
+        for(nbWords -= n; n > 0; n--)
+            REG_PXI_SEND = *buffer++;
     }
 }
 
@@ -71,10 +78,17 @@ u32 PXIReceiveWord(void)
 
 void PXIReceiveBuffer(u32 *buffer, u32 nbWords)
 {
-    for(; nbWords > 0; nbWords--)
+    while(nbWords > 0)
     {
-        while(REG_PXI_CNT & CNT_RECEIVE_FIFO_EMPTY_STATUS);
-        *buffer++ = REG_PXI_RECV;
+        // Likewise, a full FIFO can be drained without polling
+        u32 n = (REG_PXI_CNT & CNT_RECEIVE_FIFO_FULL_STATUS) ? PXI_FIFO_DEPTH : 1;
+        n = n < nbWords ? n : nbWords;
+
+        if(n == 1)
+            while(REG_PXI_CNT & CNT_RECEIVE_FIFO_EMPTY_STATUS);
+
+        for(nbWords -= n; n > 0; n--)
+            *buffer++ = REG_PXI_RECV;
     }
 }
 
@@ -18,6 +18,7 @@ typedef enum SessionState
     STATE_RECEIVED_FROM_ARM9 = 3
 } SessionState;
 
+// The state is only ever changed atomically (see setSessionState), which replaces per-session locking
 typedef struct SessionData
 {
     SessionState state;
@@ -25,8 +26,6 @@ typedef struct SessionData
 
     Handle handle;
     u32 usedStaticBuffers;
-
-    RecursiveLock lock;
 } SessionData;
 
 #define NB_STATIC_BUFFERS 21
@@ -35,11 +34,15 @@ typedef struct SessionManager
 {
     Handle sendAllBuffersToArm9Event, replySemaphore, PXISRV11CommandReceivedEvent, PXISRV11ReplySentEvent;
     u32 latest_PXI_MC5_val, pendingArm9Commands;
-    u32 receivedServiceId;
     RecursiveLock senderLock;
     bool sendingDisabled;
     SessionData sessionData[10];
 
+    // Bitmasks of session IDs
+    u32 openSessions; // protected by senderLock
+    u32 pendingSessions; // received from arm11, not yet sent to arm9 (sender thread only)
+    u32 repliedSessions; // received from arm9 (atomic, set by the receiver thread)
+
     u32 currentlyProvidedStaticBuffers, freeStaticBuffers;
 } SessionManager;
 
@@ -59,6 +62,18 @@ static inline Result assertSuccess(Result res)
     return res;
 }
 
+static inline SessionState getSessionState(SessionData *data)
+{
+    return __atomic_load_n(&data->state, __ATOMIC_ACQUIRE);
+}
+
+static inline void setSessionState(SessionData *data, SessionState from, SessionState to)
+{
+    SessionState expected = from;
+    if(!__atomic_compare_exchange_n(&data->state, &expected, to, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        svcBreak(USERBREAK_PANIC);
+}
+
 static inline s32 getMSBPosition(u32 val)
 {
     return 31 - (s32) __builtin_clz(val);
@@ -11,6 +11,7 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 #include "MyThread.h"
 #include "receiver.h"
 #include "sender.h"
+#include "tracer.h"
 #include "memory.h"
 
 Handle PXISyncInterrupt = 0, PXITransferMutex = 0;
@@ -98,6 +99,7 @@ static inline void exitPXI(void)
 static u8 ALIGN(8) receiverStack[THREAD_STACK_SIZE];
 static u8 ALIGN(8) senderStack[THREAD_STACK_SIZE];
 static u8 ALIGN(8) PXISRV11HandlerStack[THREAD_STACK_SIZE];
+static u8 ALIGN(8) tracerStack[THREAD_STACK_SIZE];
 
 // this is called before main
 void __appInit()
@@ -155,7 +157,7 @@ void initSystem()
 int main(void)
 {
     Handle handles[10] = {0}; //notification handle + service handles
-    MyThread receiverThread = {0}, senderThread = {0}, PXISRV11HandlerThread = {0};
+    MyThread receiverThread = {0}, senderThread = {0}, PXISRV11HandlerThread = {0}, tracerThread = {0};
 
     for(u32 i = 0; i < 9; i++)
         assertSuccess(srvRegisterService(handles + 1 + i, serviceNames[i], 1));
@@ -163,6 +165,7 @@ int main(void)
     assertSuccess(MyThread_Create(&receiverThread, receiver, receiverStack, THREAD_STACK_SIZE, 0x2D, -2));
     assertSuccess(MyThread_Create(&senderThread, sender, senderStack, THREAD_STACK_SIZE, 0x2D, -2));
     assertSuccess(MyThread_Create(&PXISRV11HandlerThread, PXISRV11Handler, PXISRV11HandlerStack, THREAD_STACK_SIZE, 0x2D, -2));
+    assertSuccess(MyThread_Create(&tracerThread, tracer, tracerStack, THREAD_STACK_SIZE, 0x2E, -2));
 
     assertSuccess(srvEnableNotification(&handles[0]));
 
@@ -189,6 +192,7 @@ int main(void)
                 svcBreak(USERBREAK_PANIC);
 
             data->handle = session;
+            sessionManager.openSessions |= 1u << (index - 1);
             assertSuccess(svcSignalEvent(sessionManager.sendAllBuffersToArm9Event));
 
             RecursiveLock_Unlock(&sessionManager.senderLock);
@@ -197,12 +201,13 @@ int main(void)
     }
 
     u32 PXIMC_OnPXITerminate = 0x10000; //TODO: see if this is correct
-    sessionManager.sessionData[0].state = STATE_SENT_TO_ARM9;
+    __atomic_store_n(&sessionManager.sessionData[0].state, STATE_SENT_TO_ARM9, __ATOMIC_RELEASE);
     sendPXICmdbuf(NULL, 0, &PXIMC_OnPXITerminate);
 
     assertSuccess(MyThread_Join(&receiverThread, -1LL));
     assertSuccess(MyThread_Join(&senderThread, -1LL));
     assertSuccess(MyThread_Join(&PXISRV11HandlerThread, -1LL));
+    assertSuccess(MyThread_Join(&tracerThread, -1LL));
 
     for(u32 i = 0; i < 10; i++)
         svcCloseHandle(handles[i]);
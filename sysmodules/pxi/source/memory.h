@@ -9,5 +9,4 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 #pragma once
 
 #include <3ds/types.h>
-
-void memcpy(void *dest, const void *src, u32 size);
+#include "../../../common/memfuncs.h"
@@ -9,17 +9,16 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 #include "receiver.h"
 #include "PXI.h"
 #include "memory.h"
+#include "tracer.h"
 
 static inline void receiveFromArm9(void)
 {
     u32 serviceId = PXIReceiveWord();
 
     //The offcical implementation can return 0xD90043FA
-    if(((serviceId >= 10)) || (sessionManager.sessionData[serviceId].state != STATE_SENT_TO_ARM9))
+    if(((serviceId >= 10)) || (getSessionState(&sessionManager.sessionData[serviceId]) != STATE_SENT_TO_ARM9))
         svcBreak(USERBREAK_PANIC);
 
-    sessionManager.receivedServiceId = serviceId;
-    RecursiveLock_Lock(&sessionManager.sessionData[serviceId].lock);
     u32 replyHeader = PXIReceiveWord();
     u32 replySizeWords = (replyHeader & 0x3F) + ((replyHeader & 0xFC0) >> 6) + 1;
 
@@ -29,8 +28,8 @@ static inline void receiveFromArm9(void)
 
     buf[0] = replyHeader;
     PXIReceiveBuffer(buf + 1, replySizeWords - 1);
-    sessionManager.sessionData[serviceId].state = STATE_RECEIVED_FROM_ARM9;
-    RecursiveLock_Unlock(&sessionManager.sessionData[serviceId].lock);
+    setSessionState(&sessionManager.sessionData[serviceId], STATE_SENT_TO_ARM9, STATE_RECEIVED_FROM_ARM9);
+    traceEvent(PXI_TRACE_RECEIVED_FROM_ARM9, serviceId, replyHeader);
 
     if(serviceId == 0 && shouldTerminate)
     {
@@ -41,13 +40,14 @@ static inline void receiveFromArm9(void)
     if(serviceId != 9)
     {
         s32 count;
+        __atomic_fetch_or(&sessionManager.repliedSessions, 1u << serviceId, __ATOMIC_RELEASE);
         assertSuccess(svcReleaseSemaphore(&count, sessionManager.replySemaphore, 1));
     }
     else
     {
         assertSuccess(svcSignalEvent(sessionManager.PXISRV11CommandReceivedEvent));
         assertSuccess(svcWaitSynchronization(sessionManager.PXISRV11ReplySentEvent, -1LL));
-        if( (sessionManager.sessionData[serviceId].state != STATE_SENT_TO_ARM9))
+        if(getSessionState(&sessionManager.sessionData[serviceId]) != STATE_SENT_TO_ARM9)
             svcBreak(USERBREAK_PANIC);
     }
 }
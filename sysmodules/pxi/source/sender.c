@@ -10,10 +10,10 @@ This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE fo
 #include "sender.h"
 #include "PXI.h"
 #include "memory.h"
+#include "tracer.h"
 
-Result sendPXICmdbuf(Handle *additionalHandle, u32 serviceId, u32 *buffer)
+static Result lockPXITransfer(Handle *additionalHandle)
 {
-
     Result res = 0;
 
     if(additionalHandle != NULL)
@@ -37,9 +37,47 @@ Result sendPXICmdbuf(Handle *additionalHandle, u32 serviceId, u32 *buffer)
     else
         assertSuccess(svcWaitSynchronization(PXITransferMutex, -1LL));
 
+    return 0;
+}
+
+static inline void doSendPXICmdbuf(u32 serviceId, u32 *buffer)
+{
+    traceEvent(PXI_TRACE_SENT_TO_ARM9, serviceId, buffer[0]);
     PXISendWord(serviceId & 0xFF);
     PXITriggerSync9IRQ(); //notify arm9
     PXISendBuffer(buffer, (buffer[0] & 0x3F) + ((buffer[0] & 0xFC0) >> 6) + 1);
+}
+
+Result sendPXICmdbuf(Handle *additionalHandle, u32 serviceId, u32 *buffer)
+{
+    Result res = lockPXITransfer(additionalHandle);
+    if(R_FAILED(res))
+        return res;
+
+    doSendPXICmdbuf(serviceId, buffer);
+
+    svcReleaseMutex(PXITransferMutex);
+    return 0;
+}
+
+// Streams the commands of several sessions back to back, taking the transfer mutex only once
+static Result sendPXICmdbufs(Handle *additionalHandle, u32 sessionMask)
+{
+    if(sessionMask == 0)
+        return 0;
+
+    Result res = lockPXITransfer(additionalHandle);
+    if(R_FAILED(res))
+        return res;
+
+    for(; sessionMask != 0; sessionMask &= sessionMask - 1)
+    {
+        u32 serviceId = getLSBPosition(sessionMask);
+        SessionData *data = &sessionManager.sessionData[serviceId];
+
+        setSessionState(data, STATE_RECEIVED_FROM_ARM11, STATE_SENT_TO_ARM9);
+        doSendPXICmdbuf(serviceId, data->buffer);
+    }
 
     svcReleaseMutex(PXITransferMutex);
     return 0;
@@ -85,12 +123,14 @@ void sender(void)
 {
     Handle handles[12] = {terminationRequestedEvent, sessionManager.sendAllBuffersToArm9Event, sessionManager.replySemaphore};
     Handle replyTarget = 0;
+    u32 replyTargetId = 0;
     Result res = 0;
     s32 index;
 
     u32 *cmdbuf = getThreadCommandBuffer();
 
     u32 nbIdleSessions = 0;
+    u32 busySessions = 0; // from the moment a command is received from arm11 to the moment the reply is sent
     u32 posToServiceId[9] = {0};
     RecursiveLock_Lock(&sessionManager.senderLock);
 
@@ -102,12 +142,9 @@ void sender(void)
     {
         if(replyTarget == 0) //send to arm9
         {
-            for(u32 i = 0; i < 9; i++)
+            u32 toSend = 0;
+            for(u32 pending = sessionManager.pendingSessions; pending != 0; pending &= pending - 1)
             {
-                SessionData *data = &sessionManager.sessionData[i];
-                if(data->handle == 0 || data->state != STATE_RECEIVED_FROM_ARM11)
-                    continue;
-
                 if(sessionManager.sendingDisabled)
                 {
                     if (sessionManager.pendingArm9Commands != 0 || sessionManager.latest_PXI_MC5_val == 0)
@@ -117,26 +154,23 @@ void sender(void)
                 else
                     sessionManager.pendingArm9Commands++;
 
-                RecursiveLock_Lock(&data->lock);
-                data->state = STATE_SENT_TO_ARM9;
-                res = sendPXICmdbuf(&terminationRequestedEvent, i, data->buffer);
-                RecursiveLock_Unlock(&data->lock);
+                toSend |= 1u << getLSBPosition(pending);
+            }
 
-                if(R_FAILED(res))
-                    goto terminate;
+            sessionManager.pendingSessions &= ~toSend;
+            res = sendPXICmdbufs(&terminationRequestedEvent, toSend);
+            if(R_FAILED(res))
+                goto terminate;
 
-            }
             cmdbuf[0] = 0xFFFF0000; //Kernel11
         }
 
         nbIdleSessions = 0;
-        for(u32 i = 0; i < 9; i++)
+        for(u32 idle = sessionManager.openSessions & ~busySessions; idle != 0; idle &= idle - 1)
         {
-            if(sessionManager.sessionData[i].handle != 0 && sessionManager.sessionData[i].state == STATE_IDLE)
-            {
-                handles[3 + nbIdleSessions] = sessionManager.sessionData[i].handle;
-                posToServiceId[nbIdleSessions++] = i;
-            }
+            u32 i = getLSBPosition(idle);
+            handles[3 + nbIdleSessions] = sessionManager.sessionData[i].handle;
+            posToServiceId[nbIdleSessions++] = i;
         }
 
         RecursiveLock_Unlock(&sessionManager.senderLock);
@@ -148,7 +182,7 @@ void sender(void)
             u32 i;
 
             if(index == -1)
-                for(i = 0; i < 9 && replyTarget != sessionManager.sessionData[i].handle; i++);
+                i = replyTarget != 0 ? replyTargetId : 9;
 
             else
                 i = posToServiceId[index - 3];
@@ -157,6 +191,7 @@ void sender(void)
 
             svcCloseHandle(sessionManager.sessionData[i].handle);
             sessionManager.sessionData[i].handle = replyTarget = 0;
+            sessionManager.openSessions &= ~(1u << i);
             continue;
         }
 
@@ -174,13 +209,14 @@ void sender(void)
 
             case 2: //arm9 reply
             {
-                u32 sessionId = 0;
-                for(sessionId = 0; sessionId < 9 && sessionManager.sessionData[sessionId].state != STATE_RECEIVED_FROM_ARM9; sessionId++);
-                if(sessionId == 9) svcBreak(USERBREAK_PANIC);
+                u32 replied = __atomic_load_n(&sessionManager.repliedSessions, __ATOMIC_ACQUIRE);
+                if(replied == 0) svcBreak(USERBREAK_PANIC);
+
+                u32 sessionId = getLSBPosition(replied);
+                __atomic_fetch_and(&sessionManager.repliedSessions, ~(1u << sessionId), __ATOMIC_ACQ_REL);
                 SessionData *data = &sessionManager.sessionData[sessionId];
 
-                RecursiveLock_Lock(&data->lock);
-                if(data->state != STATE_RECEIVED_FROM_ARM9) svcBreak(USERBREAK_PANIC);
+                if(getSessionState(data) != STATE_RECEIVED_FROM_ARM9) svcBreak(USERBREAK_PANIC);
                 if(sessionManager.latest_PXI_MC5_val == 2)
                 {
                     if(sessionManager.pendingArm9Commands != 0) svcBreak(USERBREAK_PANIC);
@@ -195,10 +231,10 @@ void sender(void)
 
                 releaseStaticBuffers(&data->usedStaticBuffers, 4);
 
-                data->state = STATE_IDLE;
+                setSessionState(data, STATE_RECEIVED_FROM_ARM9, STATE_IDLE);
+                busySessions &= ~(1u << sessionId);
                 replyTarget = data->handle;
-
-                RecursiveLock_Unlock(&data->lock);
+                replyTargetId = sessionId;
                 break;
             }
 
@@ -206,9 +242,8 @@ void sender(void)
             {
                 u32 serviceId = posToServiceId[index - 3];
                 SessionData *data = &sessionManager.sessionData[serviceId];
-                RecursiveLock_Lock(&data->lock);
 
-                if(data->state != STATE_IDLE) svcBreak(USERBREAK_PANIC);
+                if(getSessionState(data) != STATE_IDLE) svcBreak(USERBREAK_PANIC);
 
                 if(!(serviceId == 0 && (cmdbuf[0] >> 16) == 5)) //if not pxi:mc 5
                     sessionManager.latest_PXI_MC5_val = 0;
@@ -228,14 +263,15 @@ void sender(void)
                 if(bufSize > 0x100) svcBreak(USERBREAK_PANIC);
                 memcpy(data->buffer, cmdbuf, bufSize);
 
-                data->state = STATE_RECEIVED_FROM_ARM11;
+                traceEvent(PXI_TRACE_RECEIVED_FROM_ARM11, serviceId, cmdbuf[0]);
+                setSessionState(data, STATE_IDLE, STATE_RECEIVED_FROM_ARM11);
+                busySessions |= 1u << serviceId;
+                sessionManager.pendingSessions |= 1u << serviceId;
                 replyTarget = 0;
 
                 releaseStaticBuffers(&sessionManager.currentlyProvidedStaticBuffers, 4 - nbStaticBuffersByService[serviceId]);
                 data->usedStaticBuffers = sessionManager.currentlyProvidedStaticBuffers;
                 acquireStaticBuffers();
-
-                RecursiveLock_Unlock(&data->lock);
                 break;
             }
         }
@@ -258,7 +294,7 @@ void PXISRV11Handler(void)
     Handle handles[] = {sessionManager.PXISRV11CommandReceivedEvent, terminationRequestedEvent};
     SessionData *data = &sessionManager.sessionData[9];
 
-    data->state = STATE_SENT_TO_ARM9;
+    __atomic_store_n(&data->state, STATE_SENT_TO_ARM9, __ATOMIC_RELEASE);
     assertSuccess(svcSignalEvent(sessionManager.PXISRV11ReplySentEvent));
 
     while(true)
@@ -269,12 +305,7 @@ void PXISRV11Handler(void)
         if(index == 1) return;
         else
         {
-            RecursiveLock_Lock(&data->lock);
-
-            if(data->state != STATE_RECEIVED_FROM_ARM9)
-                svcBreak(USERBREAK_PANIC);
-
-            data->state = STATE_IDLE;
+            setSessionState(data, STATE_RECEIVED_FROM_ARM9, STATE_IDLE);
 
             if(data->buffer[0] >> 16 != 1)
             {
@@ -286,15 +317,13 @@ void PXISRV11Handler(void)
                 data->buffer[0] = 0x10040;
                 data->buffer[1] = srvPublishToSubscriber(data->buffer[1], 1);
 
-                data->state = STATE_RECEIVED_FROM_ARM11;
                 if(data->buffer[1] == 0xD8606408)
                     svcBreak(USERBREAK_PANIC);
             }
 
             assertSuccess(sendPXICmdbuf(&terminationRequestedEvent, 9, data->buffer));
-            data->state = STATE_SENT_TO_ARM9;
+            setSessionState(data, STATE_IDLE, STATE_SENT_TO_ARM9);
             assertSuccess(svcSignalEvent(sessionManager.PXISRV11ReplySentEvent));
-            RecursiveLock_Unlock(&data->lock);
         }
     }
 }
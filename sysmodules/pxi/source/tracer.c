@@ -0,0 +1,154 @@
+/*
+tracer.c
+    Low-overhead PXI traffic tracer: a ring of timestamped events and, per service, a histogram of the time
+    between a command being received from an arm11 process and its reply being received from Process9.
+    Exposed through the "pxi:trc" service.
+
+This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE for details).
+*/
+
+#include "tracer.h"
+#include "memory.h"
+
+static PXITraceEvent traceRing[PXI_TRACE_RING_SIZE];
+static u32 traceRingPos = 0; // total number of events recorded, atomic
+
+static PXILatencyHistogram latencyHistograms[PXI_TRACE_NB_SERVICES]; // receiver thread only
+static u64 receivedFromArm11Ticks[PXI_TRACE_NB_SERVICES];
+
+void traceEvent(PXITraceEventType type, u32 serviceId, u32 header)
+{
+    u64 tick = svcGetSystemTick();
+    PXITraceEvent *event = &traceRing[__atomic_fetch_add(&traceRingPos, 1, __ATOMIC_RELAXED) % PXI_TRACE_RING_SIZE];
+
+    event->tick = tick;
+    event->header = header;
+    event->serviceId = (u8)serviceId;
+    event->type = (u8)type;
+
+    if(serviceId >= 9) // PXISRV11: the requests come from arm9
+        return;
+
+    // The session state transitions order the tick write (sender thread) before its read (receiver thread)
+    if(type == PXI_TRACE_RECEIVED_FROM_ARM11)
+        receivedFromArm11Ticks[serviceId] = tick;
+    else if(type == PXI_TRACE_RECEIVED_FROM_ARM9 && receivedFromArm11Ticks[serviceId] != 0)
+    {
+        PXILatencyHistogram *histogram = &latencyHistograms[serviceId];
+        u64 latency = tick - receivedFromArm11Ticks[serviceId];
+        u32 bucket = latency >= (1ULL << 32) ? PXI_TRACE_NB_BUCKETS - 1 : (u32)getMSBPosition((u32)latency | 1);
+
+        histogram->totalTicks += latency;
+        histogram->maxTicks = latency > histogram->maxTicks ? latency : histogram->maxTicks;
+        ++histogram->count;
+        ++histogram->buckets[bucket];
+    }
+}
+
+static void handleTracerCommand(u32 *cmdbuf)
+{
+    u32 size = cmdbuf[1];
+    void *buffer = (void *)cmdbuf[3];
+    // Only the buffer described by the descriptor is mapped; the second test rejects sizes it truncates
+    bool validBuffer = cmdbuf[2] == IPC_Desc_Buffer(size, IPC_BUFFER_W) && cmdbuf[2] >> 4 == size;
+
+    switch(cmdbuf[0] >> 16)
+    {
+        case 1: // GetTraceEvents(u32 size, buffer): copies the latest events, oldest first
+        {
+            if(cmdbuf[0] != IPC_MakeHeader(1, 1, 2) || !validBuffer)
+                goto invalid_command;
+
+            u32 pos = __atomic_load_n(&traceRingPos, __ATOMIC_RELAXED);
+            u32 nb = pos < PXI_TRACE_RING_SIZE ? pos : PXI_TRACE_RING_SIZE;
+            nb = nb < size / sizeof(PXITraceEvent) ? nb : size / sizeof(PXITraceEvent);
+
+            PXITraceEvent *events = (PXITraceEvent *)buffer;
+            for(u32 i = 0; i < nb; i++)
+                events[i] = traceRing[(pos - nb + i) % PXI_TRACE_RING_SIZE];
+
+            cmdbuf[0] = IPC_MakeHeader(1, 3, 2);
+            cmdbuf[1] = 0;
+            cmdbuf[2] = nb;
+            cmdbuf[3] = pos;
+            cmdbuf[4] = IPC_Desc_Buffer(size, IPC_BUFFER_W);
+            cmdbuf[5] = (u32)buffer;
+            break;
+        }
+
+        case 2: // GetLatencyHistograms(u32 size, buffer): one PXILatencyHistogram per service ID
+        {
+            if(cmdbuf[0] != IPC_MakeHeader(2, 1, 2) || !validBuffer)
+                goto invalid_command;
+
+            u32 nb = size / sizeof(PXILatencyHistogram);
+            nb = nb < PXI_TRACE_NB_SERVICES ? nb : PXI_TRACE_NB_SERVICES;
+            memcpy(buffer, latencyHistograms, nb * sizeof(PXILatencyHistogram));
+
+            cmdbuf[0] = IPC_MakeHeader(2, 2, 2);
+            cmdbuf[1] = 0;
+            cmdbuf[2] = nb;
+            cmdbuf[3] = IPC_Desc_Buffer(size, IPC_BUFFER_W);
+            cmdbuf[4] = (u32)buffer;
+            break;
+        }
+
+        default:
+            goto invalid_command;
+    }
+
+    return;
+
+invalid_command:
+    cmdbuf[0] = IPC_MakeHeader(0, 1, 0);
+    cmdbuf[1] = 0xD900182F;
+}
+
+void tracer(void)
+{
+    Handle handles[3] = {terminationRequestedEvent};
+    Handle replyTarget = 0;
+    u32 nbHandles = 2;
+    u32 *cmdbuf = getThreadCommandBuffer();
+
+    assertSuccess(srvRegisterService(&handles[1], "pxi:trc", 1));
+
+    for(;;)
+    {
+        s32 index;
+        if(replyTarget == 0)
+            cmdbuf[0] = 0xFFFF0000; //Kernel11
+
+        Result res = svcReplyAndReceive(&index, handles, nbHandles, replyTarget);
+        replyTarget = 0;
+
+        if((u32)res == 0xC920181A) //session closed by remote
+        {
+            svcCloseHandle(handles[2]);
+            nbHandles = 2;
+            continue;
+        }
+        else if(R_FAILED(res))
+            svcBreak(USERBREAK_PANIC);
+
+        if(index == 0) //terminaton requested
+            break;
+        else if(index == 1)
+        {
+            if(nbHandles == 3)
+                svcBreak(USERBREAK_PANIC);
+            assertSuccess(svcAcceptSession(&handles[2], handles[1]));
+            nbHandles = 3;
+        }
+        else
+        {
+            handleTracerCommand(cmdbuf);
+            replyTarget = handles[2];
+        }
+    }
+
+    if(nbHandles == 3)
+        svcCloseHandle(handles[2]);
+    srvUnregisterService("pxi:trc");
+    svcCloseHandle(handles[1]);
+}
@@ -0,0 +1,43 @@
+/*
+tracer.h
+    Low-overhead PXI traffic tracer: a ring of timestamped events and, per service, a histogram of the time
+    between a command being received from an arm11 process and its reply being received from Process9.
+    Exposed through the "pxi:trc" service.
+
+This is part of 3ds_pxi, which is licensed under the MIT license (see LICENSE for details).
+*/
+
+#pragma once
+
+#include "common.h"
+
+#define PXI_TRACE_RING_SIZE         256
+#define PXI_TRACE_NB_SERVICES       10
+#define PXI_TRACE_NB_BUCKETS        32 // bucket i: latencies in [2^i, 2^(i+1)[ system ticks
+
+typedef enum PXITraceEventType
+{
+    PXI_TRACE_RECEIVED_FROM_ARM11 = 0,
+    PXI_TRACE_SENT_TO_ARM9 = 1,
+    PXI_TRACE_RECEIVED_FROM_ARM9 = 2,
+} PXITraceEventType;
+
+typedef struct PXITraceEvent
+{
+    u64 tick;
+    u32 header;
+    u8 serviceId;
+    u8 type;
+    u16 reserved;
+} PXITraceEvent;
+
+typedef struct PXILatencyHistogram
+{
+    u64 totalTicks;
+    u64 maxTicks;
+    u32 count;
+    u32 buckets[PXI_TRACE_NB_BUCKETS];
+} PXILatencyHistogram;
+
+void traceEvent(PXITraceEventType type, u32 serviceId, u32 header);
+void tracer(void);
@@ -40,6 +40,9 @@
 // IDA seems to want additional bytes as well.
 // 1024 is fine enough to put all regs in the 'T' stop reply packets
 #define GDB_BUF_LEN 1024
+// Memory transfers ('m', 'M', 'x', 'X') are done in place in the packet buffer, which is what we advertise as PacketSize.
+// Fewer, larger packets make memory dumps much faster.
+#define GDB_PACKET_BUF_LEN 0x2000
 
 #define GDB_HANDLER(name)           GDB_Handle##name
 #define GDB_QUERY_HANDLER(name)     GDB_HANDLER(Query##name)
@@ -114,7 +117,7 @@ typedef struct GDBContext
     bool enableExternalMemoryAccess;
     char *commandData, *commandEnd;
     int latestSentPacketSize;
-    char buffer[GDB_BUF_LEN + 4];
+    char buffer[GDB_PACKET_BUF_LEN + 4];
 
     char threadListData[0x800];
     u32 threadListDataPos;
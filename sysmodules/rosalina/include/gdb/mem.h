@@ -36,5 +36,6 @@ u32 GDB_SearchMemory(bool *found, GDBContext *ctx, u32 addr, u32 len, const void
 
 GDB_DECLARE_HANDLER(ReadMemory);
 GDB_DECLARE_HANDLER(WriteMemory);
+GDB_DECLARE_HANDLER(ReadMemoryRaw);
 GDB_DECLARE_HANDLER(WriteMemoryRaw);
 GDB_DECLARE_QUERY_HANDLER(SearchMemory);
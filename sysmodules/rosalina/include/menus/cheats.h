@@ -29,8 +29,13 @@
 #pragma once
 
 #include <3ds/types.h>
+#include "MyThread.h"
 
 #define CHEATS_PER_MENU_PAGE 18
+#define CHEATS_APPLY_PERIOD (50 * 1000 * 1000LL) // In ns, each tick attaches to the title once
 
 void RosalinaMenu_Cheats(void);
-void Cheat_ApplyCheats(); 
+void Cheat_ApplyCheats(void);
+
+MyThread *cheatsCreateThread(void);
+void cheatsThreadMain(void);
@@ -438,7 +438,7 @@ int GDB_SendStopReply(GDBContext *ctx, const DebugEventInfo *info)
             int total = 0;
             while(remaining > 0)
             {
-                u32 pending = (GDB_BUF_LEN - 1) / 2;
+                u32 pending = (GDB_PACKET_BUF_LEN - 1) / 2;
                 pending = pending < remaining ? pending : remaining;
 
                 int res = GDB_SendMemory(ctx, "O", 1, addr + sent, pending);
@@ -99,25 +99,14 @@ Result GDB_WriteMemoryInPage(GDBContext *ctx, const void *in, u32 addr, u32 len)
     }
 }
 
-int GDB_SendMemory(GDBContext *ctx, const char *prefix, u32 prefixLen, u32 addr, u32 len)
+static u32 GDB_ReadMemory(GDBContext *ctx, void *out, u32 addr, u32 len)
 {
-    char buf[GDB_BUF_LEN];
-    u8 membuf[GDB_BUF_LEN / 2];
-
-    if(prefix != NULL)
-        memcpy(buf, prefix, prefixLen);
-    else
-        prefixLen = 0;
-
-    if(prefixLen + 2 * len > GDB_BUF_LEN) // gdb shouldn't send requests which responses don't fit in a packet
-        return prefix == NULL ? GDB_ReplyErrno(ctx, ENOMEM) : -1;
-
     Result r = 0;
     u32 remaining = len, total = 0;
     do
     {
         u32 nb = (remaining > 0x1000 - (addr & 0xFFF)) ? 0x1000 - (addr & 0xFFF) : remaining;
-        r = GDB_ReadMemoryInPage(membuf + total, ctx, addr, nb);
+        r = GDB_ReadMemoryInPage((u8 *)out + total, ctx, addr, nb);
         if(R_SUCCEEDED(r))
         {
             addr += nb;
@@ -127,10 +116,29 @@ int GDB_SendMemory(GDBContext *ctx, const char *prefix, u32 prefixLen, u32 addr,
     }
     while(remaining > 0 && R_SUCCEEDED(r));
 
+    return total;
+}
+
+int GDB_SendMemory(GDBContext *ctx, const char *prefix, u32 prefixLen, u32 addr, u32 len)
+{
+    // The reply is built in place: memory is read right after where its hex encoding begins, then encoded forwards
+    char *buf = ctx->buffer + 1;
+
+    if(prefix == NULL)
+        prefixLen = 0;
+
+    if(prefixLen + 2 * len > GDB_PACKET_BUF_LEN) // gdb shouldn't send requests which responses don't fit in a packet
+        return prefix == NULL ? GDB_ReplyErrno(ctx, ENOMEM) : -1;
+
+    u8 *membuf = (u8 *)buf + prefixLen + len;
+    u32 total = GDB_ReadMemory(ctx, membuf, addr, len);
+
     if(total == 0)
         return prefix == NULL ? GDB_ReplyErrno(ctx, EFAULT) : -EFAULT;
     else
     {
+        if(prefix != NULL)
+            memcpy(buf, prefix, prefixLen);
         GDB_EncodeHex(buf + prefixLen, membuf, total);
         return GDB_SendPacket(ctx, buf, prefixLen + 2 * total);
     }
@@ -214,6 +222,34 @@ GDB_DECLARE_HANDLER(ReadMemory)
     return GDB_SendMemory(ctx, NULL, 0, addr, len);
 }
 
+GDB_DECLARE_HANDLER(ReadMemoryRaw)
+{
+    u32 lst[2];
+    if(GDB_ParseHexIntegerList(lst, ctx->commandData, 2, 0) == NULL)
+        return GDB_ReplyErrno(ctx, EILSEQ);
+
+    u32 addr = lst[0];
+    u32 len = lst[1];
+
+    // Read at the end of the packet buffer and escape towards its beginning. We're allowed to reply with fewer bytes than
+    // requested, which we do when the escaped data doesn't fit
+    char *buf = ctx->buffer + 1;
+    if(len > GDB_PACKET_BUF_LEN - 1)
+        len = GDB_PACKET_BUF_LEN - 1;
+
+    u8 *membuf = (u8 *)buf + GDB_PACKET_BUF_LEN - len;
+    u32 total = GDB_ReadMemory(ctx, membuf, addr, len);
+
+    if(total == 0 && len != 0)
+        return GDB_ReplyErrno(ctx, EFAULT);
+
+    u32 encodedLen;
+    buf[0] = 'b';
+    GDB_EscapeBinaryData(&encodedLen, buf + 1, membuf, total, GDB_PACKET_BUF_LEN - 1);
+
+    return GDB_SendPacket(ctx, buf, 1 + encodedLen);
+}
+
 GDB_DECLARE_HANDLER(WriteMemory)
 {
     u32 lst[2];
@@ -225,10 +261,10 @@ GDB_DECLARE_HANDLER(WriteMemory)
     u32 addr = lst[0];
     u32 len = lst[1];
 
-    if(dataStart + 2 * len >= ctx->buffer + 4 + GDB_BUF_LEN)
+    if(dataStart + 2 * len >= ctx->buffer + 4 + GDB_PACKET_BUF_LEN)
         return GDB_ReplyErrno(ctx, ENOMEM);
 
-    u8 data[GDB_BUF_LEN / 2];
+    u8 *data = (u8 *)dataStart; // decoded in place
     u32 n = GDB_DecodeHex(data, dataStart, len);
 
     if(n != len)
@@ -248,10 +284,10 @@ GDB_DECLARE_HANDLER(WriteMemoryRaw)
     u32 addr = lst[0];
     u32 len = lst[1];
 
-    if(dataStart + len >= ctx->buffer + 4 + GDB_BUF_LEN)
+    if(dataStart + len >= ctx->buffer + 4 + GDB_PACKET_BUF_LEN)
         return GDB_ReplyErrno(ctx, ENOMEM);
 
-    u8 data[GDB_BUF_LEN];
+    u8 *data = (u8 *)dataStart; // unescaped in place
     u32 n = GDB_UnescapeBinaryData(data, dataStart, len);
 
     if(n != len)
@@ -283,6 +319,8 @@ GDB_DECLARE_QUERY_HANDLER(SearchMemory)
 
     patternStart++;
     patternLen = ctx->commandEnd - patternStart;
+    if(patternLen > sizeof(pattern))
+        return GDB_ReplyErrno(ctx, ENOMEM);
 
     patternLen = GDB_UnescapeBinaryData(pattern, patternStart, patternLen);
 
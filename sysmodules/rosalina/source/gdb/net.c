@@ -94,6 +94,35 @@ u32 GDB_UnescapeBinaryData(void *dst, const void *src, u32 len)
     return dst8 - (u8 *)dst;
 }
 
+u32 GDB_EscapeBinaryData(u32 *encodedLen, void *dst, const void *src, u32 len, u32 maxEncodedLen)
+{
+    u8 *dst8 = (u8 *)dst;
+    const u8 *src8 = (const u8 *)src;
+    u32 i;
+
+    // dst may overlap src (with dst <= src), in which case we stop before overwriting what hasn't been read yet
+    for(i = 0; i < len; i++)
+    {
+        u8 c = src8[i];
+        bool escape = c == '#' || c == '$' || c == '}' || c == '*';
+        u8 *end = dst8 + (escape ? 2 : 1);
+
+        if(end > (u8 *)dst + maxEncodedLen || (src8 >= (u8 *)dst && end > src8 + i + 1))
+            break;
+
+        if(escape)
+        {
+            *dst8++ = '}';
+            *dst8++ = c ^ 0x20;
+        }
+        else
+            *dst8++ = c;
+    }
+
+    *encodedLen = dst8 - (u8 *)dst;
+    return i;
+}
+
 const char *GDB_ParseIntegerList(u32 *dst, const char *src, u32 nb, char sep, char lastSep, u32 base, bool allowPrefix)
 {
     const char *pos = src;
@@ -132,11 +161,19 @@ const char *GDB_ParseHexIntegerList(u32 *dst, const char *src, u32 nb, char last
 
 int GDB_ReceivePacket(GDBContext *ctx)
 {
-    char backupbuf[GDB_BUF_LEN + 4];
-    memcpy(backupbuf, ctx->buffer, ctx->latestSentPacketSize);
+    char c;
+    int r = soc_recv(ctx->super.sockfd, &c, 1, MSG_PEEK);
+    if(r < 1)
+        return -1;
+    if(c == '-') // the latest packet we sent is still in the buffer
+    {
+        soc_send(ctx->super.sockfd, ctx->buffer, ctx->latestSentPacketSize, 0);
+        return 0;
+    }
+
     memset(ctx->buffer, 0, sizeof(ctx->buffer));
 
-    int r = soc_recv(ctx->super.sockfd, ctx->buffer, sizeof(ctx->buffer), MSG_PEEK);
+    r = soc_recv(ctx->super.sockfd, ctx->buffer, sizeof(ctx->buffer), MSG_PEEK);
     if(r < 1)
         return -1;
     if(ctx->buffer[0] == '+') // GDB sometimes acknowleges TCP acknowledgment packets (yes...). IDA does it properly
@@ -156,11 +193,6 @@ int GDB_ReceivePacket(GDBContext *ctx)
         if(r == -1)
             goto packet_error;
     }
-    else if(ctx->buffer[0] == '-')
-    {
-        soc_send(ctx->super.sockfd, backupbuf, ctx->latestSentPacketSize, 0);
-        return 0;
-    }
     int maxlen = r > (int)sizeof(ctx->buffer) ? (int)sizeof(ctx->buffer) : r;
 
     if(ctx->buffer[0] == '$') // normal packet
@@ -231,7 +263,8 @@ int GDB_SendPacket(GDBContext *ctx, const char *packetData, u32 len)
 {
     ctx->buffer[0] = '$';
 
-    memcpy(ctx->buffer + 1, packetData, len);
+    if(packetData != ctx->buffer + 1) // memory replies are built in place
+        memcpy(ctx->buffer + 1, packetData, len);
 
     char *checksumLoc = ctx->buffer + len + 1;
     *checksumLoc++ = '#';
@@ -112,9 +112,9 @@ GDB_DECLARE_QUERY_HANDLER(Supported)
         "PacketSize=%x;"
         "qXfer:features:read+;qXfer:osdata:read+;"
         "QStartNoAckMode+;QThreadEvents+;QCatchSyscalls+;"
-        "vContSupported+;swbreak+",
+        "vContSupported+;swbreak+;binary-upload+",
 
-        GDB_BUF_LEN // should have been sizeof(ctx->buffer) but GDB memory functions are bugged
+        GDB_PACKET_BUF_LEN
     );
 }
 
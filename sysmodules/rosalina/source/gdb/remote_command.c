@@ -335,6 +335,8 @@ GDB_DECLARE_QUERY_HANDLER(Rcmd)
     const char *errstr = "Unrecognized command.\n";
     u32 len = strlen(ctx->commandData);
 
+    if(len / 2 >= sizeof(commandData))
+        return GDB_ReplyErrno(ctx, ENOMEM);
     if(len == 0 || (len % 2) == 1 || GDB_DecodeHex(commandData, ctx->commandData, len / 2) != len / 2)
         return GDB_ReplyErrno(ctx, EILSEQ);
     commandData[len / 2] = 0;
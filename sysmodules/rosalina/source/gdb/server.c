@@ -237,6 +237,7 @@ static const struct
     { 'Q', GDB_HANDLER(WriteQuery) },
     { 'T', GDB_HANDLER(IsThreadAlive) },
     { 'v', GDB_HANDLER(VerboseCommand) },
+    { 'x', GDB_HANDLER(ReadMemoryRaw) },
     { 'X', GDB_HANDLER(WriteMemoryRaw) },
     { 'z', GDB_HANDLER(ToggleStopPoint) },
     { 'Z', GDB_HANDLER(ToggleStopPoint) },
@@ -34,6 +34,7 @@
 #include "utils.h"
 #include "MyThread.h"
 #include "menus/process_patches.h"
+#include "menus/cheats.h"
 #include "menus/miscellaneous.h"
 
 // this is called before main
@@ -110,6 +111,7 @@ int main(void)
     Handle notificationHandle;
 
     MyThread *menuThread = menuCreateThread(), *errDispThread = errDispCreateThread(), *hbldrThread = hbldrCreateThread();
+    MyThread *cheatsThread = cheatsCreateThread();
 
     if(R_FAILED(srvEnableNotification(&notificationHandle)))
         svcBreak(USERBREAK_ASSERT);
@@ -141,6 +143,7 @@ int main(void)
     MyThread_Join(menuThread, -1LL);
     MyThread_Join(errDispThread, -1LL);
     MyThread_Join(hbldrThread, -1LL);
+    MyThread_Join(cheatsThread, -1LL);
 
     svcCloseHandle(notificationHandle);
     return 0;
@@ -33,7 +33,6 @@
 #include "menus.h"
 #include "utils.h"
 #include "menus/n3ds.h"
-#include "menus/cheats.h"
 #include "minisoc.h"
 
 u32 waitInputWithTimeout(u32 msec)
@@ -167,10 +166,6 @@ void menuThreadMain(void)
                 menuLeave();
             }
         }
-        else
-        {
-        Cheat_ApplyCheats(); 
-        }
         svcSleepThread(50 * 1000 * 1000LL);
     }
 }
@@ -44,6 +44,19 @@ typedef struct CheatProcessInfo
     u64 titleId;
 } CheatProcessInfo;
 
+#define CHEAT_OP_DATA       0xF0 // Payload line of an E type code
+#define CHEAT_OP_INVALID    0xFF // Empty line, unknown code type or truncated E type code
+#define CHEAT_NO_TARGET     0xFFFF
+
+typedef struct CheatOp
+{
+    u8 type;        // Code type, 0xD0-0xDD for the D types
+    u8 reserved;
+    u16 target;     // Conditionals: D0 line closing the block when it can be jumped over. E type: last payload line
+    u32 address;    // Masked first word, or the raw first word for payload lines
+    u32 value;
+} CheatOp;
+
 typedef struct CheatDescription
 {
     u32 active;
@@ -51,14 +64,50 @@ typedef struct CheatDescription
     u32 keyActivated;
     u32 keyCombo;
     char name[40];
+    u32 fileOffset;     // Code lines in the cheat file, only parsed once the cheat gets enabled
+    u32 fileSize;
     u32 codesCount;
-    u64 codes[0];
+    CheatOp* ops;       // Compiled when the cheat is first applied
 } CheatDescription;
 
-CheatDescription* cheats[1024] = { 0 };
-u8 cheatFileBuffer[16384] = { 0 };
-u32 cheatFilePos = 0;
-u8 cheatBuffer[16384] = { 0 };
+#define CHEATS_MAX          256
+#define CHEAT_INDEX_MAGIC   0x30584943 // "CIX0"
+
+typedef struct CheatIndexHeader
+{
+    u32 magic;
+    u32 nbCheats;
+    u64 fileSize;
+    u64 timestamp;
+} CheatIndexHeader;
+
+typedef struct CheatIndexEntry
+{
+    u32 fileOffset;
+    u32 fileSize;
+    u32 codesCount;
+    u32 keyCombo;
+    u32 keyActivated;
+    char name[40];
+} CheatIndexEntry;
+
+typedef struct CheatFileReader
+{
+    IFile file;
+    u32 fileSize;
+    u32 end;
+    u32 bufStart;   // File offset of cheatFileBuffer[0]
+    u32 bufPos;
+    u32 bufLen;
+} CheatFileReader;
+
+static CheatDescription cheats[CHEATS_MAX];
+static u8 cheatFileBuffer[0x1000];
+static char cheatFilePath[64];
+static u64 cheatCodes[2048];    // Codes of the cheat being compiled
+
+static CheatOp cheatOps[sizeof(cheatCodes) / sizeof(u64)];
+static u32 cheatOpsCount = 0;
 
 static CheatProcessInfo cheatinfo[0x40] = { 0 };
 
@@ -95,10 +144,8 @@ typedef struct CheatState
     u32 index;
     u32 offset;
     u32 data;
-    u8 typeELine;
-    u8 typeEIdx;
 
-    s8 loopLine;
+    s32 loopLine;
     u32 loopCount;
 
     u32 ifStack;
@@ -109,114 +156,321 @@ typedef struct CheatState
 } CheatState;
 
 CheatState cheat_state = { 0 };
-u8 cheatCount = 0;
+s32 cheatCount = 0;
 u8 hasKeyActivated = 0;
 u64 cheatTitleInfo = -1ULL;
+static RecursiveLock cheatsLock;
 
 char failureReason[64];
 
+#define CHEAT_REGION_CACHE_SIZE 8
+
+typedef struct CheatMemoryRegion
+{
+    u32 base;
+    u32 size;
+} CheatMemoryRegion;
+
+// Writes are combined into runs that never cross a page, hence a single mapping
+typedef struct CheatWriteBuffer
+{
+    u32 address;
+    u32 size;
+    u8 data[0x1000];
+} CheatWriteBuffer;
+
+static CheatMemoryRegion cheatRegions[CHEAT_REGION_CACHE_SIZE];
+static u32 cheatRegionsCount = 0, cheatRegionsNext = 0;
+static CheatWriteBuffer cheatWriteBuffer;
+
+static void Cheat_ResetMemoryCache(void)
+{
+    cheatRegionsCount = 0;
+    cheatRegionsNext = 0;
+    cheatWriteBuffer.size = 0;
+}
+
 static bool Cheat_IsValidAddress(const Handle processHandle, u32 address, u32 size)
 {
+    for (u32 i = 0; i < cheatRegionsCount; i++)
+    {
+        if (cheatRegions[i].base <= address && address <= cheatRegions[i].base + cheatRegions[i].size - size)
+        {
+            return true;
+        }
+    }
+
     MemInfo info;
     PageInfo out;
 
     Result res = svcQueryDebugProcessMemory(&info, &out, processHandle, address);
     if (R_SUCCEEDED(res) && info.state != MEMSTATE_FREE && info.base_addr > 0 && info.base_addr <= address && address <= info.base_addr + info.size - size) {
+        cheatRegions[cheatRegionsNext].base = info.base_addr;
+        cheatRegions[cheatRegionsNext].size = info.size;
+        cheatRegionsNext = (cheatRegionsNext + 1) % CHEAT_REGION_CACHE_SIZE;
+        if (cheatRegionsCount < CHEAT_REGION_CACHE_SIZE)
+        {
+            cheatRegionsCount++;
+        }
         return true;
     }
     return false;
 }
 
-static u32 ReadWriteBuffer32 = 0;
-static u16 ReadWriteBuffer16 = 0;
-static u8 ReadWriteBuffer8 = 0;
+static bool Cheat_FlushWrites(const Handle processHandle)
+{
+    u32 size = cheatWriteBuffer.size;
+    cheatWriteBuffer.size = 0;
+    return size == 0 || R_SUCCEEDED(svcWriteProcessMemory(processHandle, cheatWriteBuffer.data, cheatWriteBuffer.address, size));
+}
 
-static bool Cheat_Write8(const Handle processHandle, u32 offset, u8 value)
+static bool Cheat_Write(const Handle processHandle, u32 address, const void *value, u32 size)
 {
-    if (Cheat_IsValidAddress(processHandle, cheat_state.offset + offset, 1))
+    if (!Cheat_IsValidAddress(processHandle, address, size))
     {
-        *((u8*) (&ReadWriteBuffer8)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer8, cheat_state.offset + offset, 1));
+        return false;
     }
-    return false;
+
+    u32 end = cheatWriteBuffer.address + cheatWriteBuffer.size;
+    if (cheatWriteBuffer.size == 0 || address != end || ((address + size - 1) & ~0xFFF) != (cheatWriteBuffer.address & ~0xFFF))
+    {
+        if (!Cheat_FlushWrites(processHandle))
+        {
+            return false;
+        }
+        cheatWriteBuffer.address = address;
+    }
+
+    memcpy(cheatWriteBuffer.data + cheatWriteBuffer.size, value, size);
+    cheatWriteBuffer.size += size;
+    return true;
+}
+
+static bool Cheat_Write8(const Handle processHandle, u32 offset, u8 value)
+{
+    return Cheat_Write(processHandle, cheat_state.offset + offset, &value, 1);
 }
 
 static bool Cheat_Write16(const Handle processHandle, u32 offset, u16 value)
 {
-    if (Cheat_IsValidAddress(processHandle, cheat_state.offset + offset, 2))
-    {
-        *((u16*) (&ReadWriteBuffer16)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer16, cheat_state.offset + offset, 2));
-    }
-    return false;
+    return Cheat_Write(processHandle, cheat_state.offset + offset, &value, 2);
 }
 
 static bool Cheat_Write32(const Handle processHandle, u32 offset, u32 value)
 {
-    if (Cheat_IsValidAddress(processHandle, cheat_state.offset + offset, 4))
+    return Cheat_Write(processHandle, cheat_state.offset + offset, &value, 4);
+}
+
+static bool Cheat_Read(const Handle processHandle, u32 address, void *value, u32 size)
+{
+    if (!Cheat_IsValidAddress(processHandle, address, size))
+    {
+        return false;
+    }
+
+    // Pending writes to the same bytes have to land first
+    if (cheatWriteBuffer.size != 0 && address < cheatWriteBuffer.address + cheatWriteBuffer.size && cheatWriteBuffer.address < address + size)
     {
-        *((u32*) (&ReadWriteBuffer32)) = value;
-        return R_SUCCEEDED(svcWriteProcessMemory(processHandle, &ReadWriteBuffer32, cheat_state.offset + offset, 4));
+        if (!Cheat_FlushWrites(processHandle))
+        {
+            return false;
+        }
     }
-    return false;
+
+    return R_SUCCEEDED(svcReadProcessMemory(value, processHandle, address, size));
 }
 
 static bool Cheat_Read8(const Handle processHandle, u32 offset, u8* retValue)
 {
-    if (Cheat_IsValidAddress(processHandle, cheat_state.offset + offset, 1))
-    {
-        Result res = svcReadProcessMemory(&ReadWriteBuffer8, processHandle, cheat_state.offset + offset, 1);
-        *retValue = *((u8*) (&ReadWriteBuffer8));
-        return R_SUCCEEDED(res);
-    }
-    return false;
+    return Cheat_Read(processHandle, cheat_state.offset + offset, retValue, 1);
 }
 
 static bool Cheat_Read16(const Handle processHandle, u32 offset, u16* retValue)
 {
-    if (Cheat_IsValidAddress(processHandle, cheat_state.offset + offset, 2))
-    {
-        Result res = svcReadProcessMemory(&ReadWriteBuffer16, processHandle, cheat_state.offset + offset, 2);
-        *retValue = *((u16*) (&ReadWriteBuffer16));
-        return R_SUCCEEDED(res);
-    }
-    return false;
+    return Cheat_Read(processHandle, cheat_state.offset + offset, retValue, 2);
 }
 
 static bool Cheat_Read32(const Handle processHandle, u32 offset, u32* retValue)
 {
-    if (Cheat_IsValidAddress(processHandle, cheat_state.offset + offset, 4))
+    return Cheat_Read(processHandle, cheat_state.offset + offset, retValue, 4);
+}
+
+static inline bool Cheat_IsConditional(u8 type)
+{
+    return (type >= 0x3 && type <= 0xA) || type == 0xDD;
+}
+
+static u16 Cheat_FindBlockEnd(const CheatOp *ops, u32 codesCount, u32 index)
+{
+    // A skipped block can be jumped over as long as walking it would only push and pop its own nested conditionals
+    u32 depth = 0;
+    for (u32 i = index + 1; i < codesCount; i++)
     {
-        Result res = svcReadProcessMemory(&ReadWriteBuffer32, processHandle, cheat_state.offset + offset, 4);
-        *retValue = *((u32*) (&ReadWriteBuffer32));
-        return R_SUCCEEDED(res);
+        u8 type = ops[i].type;
+        if (Cheat_IsConditional(type))
+        {
+            depth++;
+        }
+        else if (type == 0xD0)
+        {
+            if (depth == 0)
+            {
+                return (u16) i;
+            }
+            depth--;
+        }
+        else if (type == 0xE)
+        {
+            i = ops[i].target;
+        }
+        else if (type == 0xC || type == 0xD1 || type == 0xD2 || type == CHEAT_OP_INVALID)
+        {
+            break;
+        }
     }
-    return false;
+    return CHEAT_NO_TARGET;
 }
 
-static u8 typeEMapping[] = { 4 << 3, 5 << 3, 6 << 3, 7 << 3, 0 << 3, 1 << 3, 2 << 3, 3 << 3 };
+// Drops the ops of the cheats that are off, they are compiled again if enabled, and packs the others at the start of the pool
+static void Cheat_CompactOps(void)
+{
+    for (s32 i = 0; i < cheatCount; i++)
+    {
+        if (!cheats[i].active)
+        {
+            cheats[i].ops = NULL;
+        }
+    }
+
+    // The kept cheats are moved down in pool order, so that no move overwrites ops still to be moved
+    const CheatOp *done = cheatOps;
+    u32 count = 0;
+    for (;;)
+    {
+        CheatDescription *next = NULL;
+        for (s32 i = 0; i < cheatCount; i++)
+        {
+            if (cheats[i].ops != NULL && cheats[i].ops >= done && (next == NULL || cheats[i].ops < next->ops))
+            {
+                next = &cheats[i];
+            }
+        }
+        if (next == NULL)
+        {
+            break;
+        }
+
+        const CheatOp *ops = next->ops;
+        for (u32 i = 0; i < next->codesCount; i++)
+        {
+            cheatOps[count + i] = ops[i];
+        }
+        done = ops + next->codesCount;
+        next->ops = &cheatOps[count];
+        count += next->codesCount;
+    }
+
+    cheatOpsCount = count;
+}
 
-static u8 Cheat_GetNextTypeE(const CheatDescription* cheat)
+static bool Cheat_Compile(CheatDescription* const cheat, const u64* codes)
 {
+    u32 codesCount = cheat->codesCount;
+    if (codesCount > sizeof(cheatOps) / sizeof(CheatOp) - cheatOpsCount)
+    {
+        Cheat_CompactOps();
+        if (codesCount > sizeof(cheatOps) / sizeof(CheatOp) - cheatOpsCount)
+        {
+            return false;
+        }
+    }
 
-    if (cheat_state.typeEIdx == 7)
+    CheatOp *ops = &cheatOps[cheatOpsCount];
+    for (u32 i = 0; i < codesCount; i++)
     {
-        cheat_state.typeEIdx = 0;
-        cheat_state.typeELine++;
+        u32 arg0 = (u32) (codes[i] >> 32);
+        u32 arg1 = (u32) codes[i];
+        u32 code = arg0 >> 28;
+        CheatOp *op = &ops[i];
+
+        op->type = code == 0xD ? (u8) (arg0 >> 24) : (u8) code;
+        op->target = CHEAT_NO_TARGET;
+        op->address = arg0 & 0x0FFFFFFF;
+        op->value = arg1;
+
+        if ((arg0 == 0 && arg1 == 0) || code == 0xF || op->type > 0xDD)
+        {
+            op->type = CHEAT_OP_INVALID;
+        }
+        else if (code == 0xE)
+        {
+            // The payload lines are kept as-is, byte n of the payload being byte n % 8 of (first word, second word) in little endian
+            u32 nbLines = (arg1 >> 3) + ((arg1 & 7) != 0);
+            if (nbLines >= codesCount - i)
+            {
+                op->type = CHEAT_OP_INVALID;
+                continue;
+            }
+
+            op->target = (u16) (i + nbLines);
+            for (u32 j = i + 1; j <= i + nbLines; j++)
+            {
+                ops[j].type = CHEAT_OP_DATA;
+                ops[j].target = CHEAT_NO_TARGET;
+                ops[j].address = (u32) (codes[j] >> 32);
+                ops[j].value = (u32) codes[j];
+            }
+            i += nbLines;
+        }
     }
-    else
+
+    for (u32 i = 0; i < codesCount; i++)
+    {
+        if (Cheat_IsConditional(ops[i].type))
+        {
+            ops[i].target = Cheat_FindBlockEnd(ops, codesCount, i);
+        }
+        else if (ops[i].type == 0xE)
+        {
+            i = ops[i].target;
+        }
+    }
+
+    cheatOpsCount += codesCount;
+    cheat->ops = ops;
+    return true;
+}
+
+static inline u8 Cheat_GetTypeEByte(const CheatOp *op, u32 idx)
+{
+    const CheatOp *line = op + 1 + (idx >> 3);
+    return (u8) (((idx & 4) ? line->value : line->address) >> ((idx & 3) << 3));
+}
+
+static bool Cheat_PushConditional(const CheatOp *op, u32 skip)
+{
+    u8 ifCount = cheat_state.ifCount;
+
+    cheat_state.ifStack <<= 1;
+    cheat_state.ifStack |= (skip & 0x1);
+    cheat_state.ifCount++;
+
+    // Go straight to the D0 line closing the block, unless the D0 lines inside it would act on the repeat block instead
+    if (skip && op->target != CHEAT_NO_TARGET && (cheat_state.loopLine == -1 || ifCount >= cheat_state.storedIfCount))
     {
-        cheat_state.typeEIdx++;
+        cheat_state.index = op->target;
+        return true;
     }
-    return (u8) ((cheat->codes[cheat_state.typeELine] >> (typeEMapping[cheat_state.typeEIdx])) & 0xFF);
+    return false;
 }
 
-static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription* const cheat)
+static u32 Cheat_RunOps(const Handle processHandle, const CheatDescription* const cheat)
 {
+    const CheatOp *ops = cheat->ops;
+
     cheat_state.index = 0;
     cheat_state.offset = 0;
     cheat_state.data = 0;
-    cheat_state.index = 0;
     cheat_state.loopCount = 0;
     cheat_state.loopLine = -1;
     cheat_state.ifStack = 0;
@@ -227,16 +481,9 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
     while (cheat_state.index < cheat->codesCount)
     {
         u32 skipExecution = cheat_state.ifStack & 0x00000001;
-        u32 arg0 = (u32) ((cheat->codes[cheat_state.index] >> 32) & 0x00000000FFFFFFFFULL);
-        u32 arg1 = (u32) ((cheat->codes[cheat_state.index]) & 0x00000000FFFFFFFFULL);
-        if (arg0 == 0 && arg1 == 0)
-        {
-            return 0;
-        }
-        u32 code = ((arg0 >> 28) & 0x0F);
-        u32 subcode = ((arg0 >> 24) & 0x0F);
+        const CheatOp *op = &ops[cheat_state.index];
 
-        switch (code)
+        switch (op->type)
         {
             case 0x0:
                 // 0 Type
@@ -244,7 +491,7 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Description: 32bit write of YYYYYYYY to 0XXXXXXX.
                 if (!skipExecution)
                 {
-                    if (!Cheat_Write32(processHandle, (arg0 & 0x0FFFFFFF), arg1)) return 0;
+                    if (!Cheat_Write32(processHandle, op->address, op->value)) return 0;
                 }
                 break;
             case 0x1:
@@ -253,7 +500,7 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Description: 16bit write of YYYY to 0XXXXXXX.
                 if (!skipExecution)
                 {
-                    if (!Cheat_Write16(processHandle, (arg0 & 0x0FFFFFFF), (u16) (arg1 & 0xFFFF))) return 0;
+                    if (!Cheat_Write16(processHandle, op->address, (u16) (op->value & 0xFFFF))) return 0;
                 }
                 break;
             case 0x2:
@@ -262,7 +509,7 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Description: 8bit write of YY to 0XXXXXXX.
                 if (!skipExecution)
                 {
-                    if (!Cheat_Write8(processHandle, (arg0 & 0x0FFFFFFF), (u8) (arg1 & 0xFF))) return 0;
+                    if (!Cheat_Write8(processHandle, op->address, (u8) (op->value & 0xFF))) return 0;
                 }
                 break;
             case 0x3:
@@ -272,21 +519,9 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is less than the value YYYYYYYY.
                 // Example: 323D6B28 10000000
             {
-                u32 newSkip;
                 u32 value = 0;
-                if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if (value < arg1)
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read32(processHandle, op->address, &value)) return 0;
+                if (Cheat_PushConditional(op, skipExecution || !(value < op->value))) continue;
             }
                 break;
             case 0x4:
@@ -296,21 +531,9 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is greater than the value YYYYYYYY.
                 // Example: 423D6B28 10000000
             {
-                u32 newSkip;
                 u32 value = 0;
-                if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if (value > arg1)
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read32(processHandle, op->address, &value)) return 0;
+                if (Cheat_PushConditional(op, skipExecution || !(value > op->value))) continue;
             }
                 break;
             case 0x5:
@@ -320,21 +543,9 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is equal to the value YYYYYYYY.
                 // Example: 523D6B28 10000000
             {
-                u32 newSkip;
                 u32 value = 0;
-                if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if (value == arg1)
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read32(processHandle, op->address, &value)) return 0;
+                if (Cheat_PushConditional(op, skipExecution || !(value == op->value))) continue;
             }
                 break;
             case 0x6:
@@ -344,21 +555,9 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is not equal to the value YYYYYYYY.
                 // Example: 623D6B28 10000000
             {
-                u32 newSkip;
                 u32 value = 0;
-                if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if (value != arg1)
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read32(processHandle, op->address, &value)) return 0;
+                if (Cheat_PushConditional(op, skipExecution || !(value != op->value))) continue;
             }
                 break;
             case 0x7:
@@ -368,22 +567,10 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is less than the value YYYY.
                 // Example: 723D6B28 00005400
             {
-                u32 newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
                 u16 value = 0;
-                if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if ((value & (~mask)) < (arg1 & 0xFFFF))
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read16(processHandle, op->address, &value)) return 0;
+                value &= ~(op->value >> 16);
+                if (Cheat_PushConditional(op, skipExecution || !(value < (op->value & 0xFFFF)))) continue;
             }
                 break;
             case 0x8:
@@ -393,22 +580,10 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is greater than the value YYYY.
                 // Example: 823D6B28 00005400
             {
-                u32 newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
                 u16 value = 0;
-                if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if ((value & (~mask)) > (arg1 & 0xFFFF))
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read16(processHandle, op->address, &value)) return 0;
+                value &= ~(op->value >> 16);
+                if (Cheat_PushConditional(op, skipExecution || !(value > (op->value & 0xFFFF)))) continue;
             }
                 break;
             case 0x9:
@@ -418,22 +593,10 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is equal to the value YYYY.
                 // Example: 923D6B28 00005400
             {
-                u32 newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
                 u16 value = 0;
-                if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if ((value & (~mask)) == (arg1 & 0xFFFF))
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read16(processHandle, op->address, &value)) return 0;
+                value &= ~(op->value >> 16);
+                if (Cheat_PushConditional(op, skipExecution || !(value == (op->value & 0xFFFF)))) continue;
             }
                 break;
             case 0xA:
@@ -443,34 +606,22 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // Simple: If the value at address 0XXXXXXX is not equal to the value YYYY.
                 // Example: A23D6B28 00005400
             {
-                u32 newSkip;
-                u16 mask = (u16) ((arg1 >> 16) & 0xFFFF);
                 u16 value = 0;
-                if (!Cheat_Read16(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0;
-                if ((value & (~mask)) != (arg1 & 0xFFFF))
-                {
-                    newSkip = 0;
-                }
-                else
-                {
-                    newSkip = 1;
-                }
-
-                cheat_state.ifStack <<= 1;
-                cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                cheat_state.ifCount++;
+                if (!skipExecution && !Cheat_Read16(processHandle, op->address, &value)) return 0;
+                value &= ~(op->value >> 16);
+                if (Cheat_PushConditional(op, skipExecution || !(value != (op->value & 0xFFFF)))) continue;
             }
                 break;
 
             case 0xB:
                 // B Type
                 // Format: BXXXXXXX 00000000
-                // Description: Loads offset register with value at given XXXXXXX 
+                // Description: Loads offset register with value at given XXXXXXX
                 if (!skipExecution)
                 {
-                    u32 value; 
-                    if (!Cheat_Read32(processHandle, arg0 & 0x0FFFFFFF, &value)) return 0; 
-                    cheat_state.offset = value; 
+                    u32 value;
+                    if (!Cheat_Read32(processHandle, op->address, &value)) return 0;
+                    cheat_state.offset = value;
                 }
                 break;
             case 0xC:
@@ -487,81 +638,35 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // D2000000 00000000
 
                 cheat_state.loopLine = cheat_state.index;
-                cheat_state.loopCount = arg1;
+                cheat_state.loopCount = op->value;
                 cheat_state.storedStack = cheat_state.ifStack;
                 cheat_state.storedIfCount = cheat_state.ifCount;
                 break;
-            case 0xD:
-                switch (subcode)
+            case 0xD0:
+                // D0 Type
+                // Format: D0000000 00000000
+                // Description: ends most recent conditional.
+                // Simple: type 3 through A are all "conditionals," the conditional most recently executed before this line will be terminated by it.
+                // Example:
+
+                // 94000130 FFFB0000
+                // 74000100 FF00000C
+                // 023D6B28 0009896C
+                // D0000000 00000000
+
+                // The 7 type line would be terminated.
+                if (cheat_state.loopLine != -1)
                 {
-                    case 0x00:
-                        // D0 Type
-                        // Format: D0000000 00000000
-                        // Description: ends most recent conditional.
-                        // Simple: type 3 through A are all "conditionals," the conditional most recently executed before this line will be terminated by it.
-                        // Example:
-
-                        // 94000130 FFFB0000
-                        // 74000100 FF00000C
-                        // 023D6B28 0009896C
-                        // D0000000 00000000
-
-                        // The 7 type line would be terminated.
-                        if (cheat_state.loopLine != -1)
-                        {
-                            if (cheat_state.ifCount > 0 && cheat_state.ifCount > cheat_state.storedIfCount)
-                            {
-                                cheat_state.ifStack >>= 1;
-                                cheat_state.ifCount--;
-                            }
-                            else
-                            {
+                    if (cheat_state.ifCount > 0 && cheat_state.ifCount > cheat_state.storedIfCount)
+                    {
+                        cheat_state.ifStack >>= 1;
+                        cheat_state.ifCount--;
+                    }
+                    else
+                    {
 
-                                if (cheat_state.loopCount > 0)
-                                {
-                                    cheat_state.loopCount--;
-                                    if (cheat_state.loopCount == 0)
-                                    {
-                                        cheat_state.loopLine = -1;
-                                    }
-                                    else
-                                    {
-                                        if (cheat_state.loopLine != -1)
-                                        {
-                                            cheat_state.index = cheat_state.loopLine;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        else
-                        {
-                            if (cheat_state.ifCount > 0)
-                            {
-                                cheat_state.ifStack >>= 1;
-                                cheat_state.ifCount--;
-                            }
-                        }
-                        break;
-                    case 0x01:
-                        // D1 Type
-                        // Format: D1000000 00000000
-                        // Description: ends repeat block.
-                        // Simple: will end all conditionals within a C type code, along with the C type itself.
-                        // Example:
-
-                        // 94000130 FFFB0000
-                        // C0000000 00000010
-                        // 8453DA0C 00000200
-                        // 023D6B28 0009896C
-                        // D6000000 00000005
-                        // D1000000 00000000
-
-                        // The C line, 8 line, 0 line, and D6 line would be terminated.
                         if (cheat_state.loopCount > 0)
                         {
-                            cheat_state.ifStack = cheat_state.storedStack;
-                            cheat_state.ifCount = cheat_state.storedIfCount;
                             cheat_state.loopCount--;
                             if (cheat_state.loopCount == 0)
                             {
@@ -569,207 +674,229 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                             }
                             else
                             {
-                                if (cheat_state.loopLine != -1)
-                                {
-                                    cheat_state.index = cheat_state.loopLine;
-                                }
+                                cheat_state.index = cheat_state.loopLine;
                             }
                         }
-                        break;
-                    case 0x02:
-                        // D2 Type
-                        // Format: D2000000 00000000
-                        // Description: ends all conditionals/repeats before it and sets offset and stored to zero.
-                        // Simple: ends all lines.
-                        // Example:
-
-                        // 94000130 FEEF0000
-                        // C0000000 00000010
-                        // 8453DA0C 00000200
-                        // 023D6B28 0009896C
-                        // D6000000 00000005
-                        // D2000000 00000000
-
-                        // All lines would terminate.
-                        if (cheat_state.loopCount > 0)
-                        {
-                            cheat_state.loopCount--;
-                            if (cheat_state.loopCount == 0)
-                            {
-                                cheat_state.data = 0;
-                                cheat_state.offset = 0;
-                                cheat_state.loopLine = -1;
+                    }
+                }
+                else
+                {
+                    if (cheat_state.ifCount > 0)
+                    {
+                        cheat_state.ifStack >>= 1;
+                        cheat_state.ifCount--;
+                    }
+                }
+                break;
+            case 0xD1:
+                // D1 Type
+                // Format: D1000000 00000000
+                // Description: ends repeat block.
+                // Simple: will end all conditionals within a C type code, along with the C type itself.
+                // Example:
 
-                                cheat_state.ifStack = 0;
-                                cheat_state.ifCount = 0;
-                            }
-                            else
-                            {
-                                if (cheat_state.loopLine != -1)
-                                {
-                                    cheat_state.index = cheat_state.loopLine;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            cheat_state.data = 0;
-                            cheat_state.offset = 0;
-                            cheat_state.ifStack = 0;
-                            cheat_state.ifCount = 0;
-                        }
-                        break;
-                    case 0x03:
-                        // D3 Type
-                        // Format: D3000000 XXXXXXXX
-                        // Description: sets offset.
-                        // Simple: loads the address X so that lines after can modify the value at address X.
-                        // Note: used with the D4, D5, D6, D7, D8, and DC types.
-                        // Example: D3000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            cheat_state.offset = arg1;
-                        }
-                        break;
-                    case 0x04:
-                        // D4 Type
-                        // Format: D4000000 YYYYYYYY
-                        // Description: adds to the stored address' value.
-                        // Simple: adds to the value at the address defined by lines D3, D9, DA, and DB.
-                        // Note: used with the D3, D9, DA, DB, DC types.
-                        // Example: D4000000 00000025
-                        if (!skipExecution)
-                        {
-                            cheat_state.data += arg1;
-                        }
-                        break;
-                    case 0x05:
-                        // D5 Type
-                        // Format: D5000000 YYYYYYYY
-                        // Description: sets the stored address' value.
-                        // Simple: makes the value at the address defined by lines D3, D9, DA, and DB to YYYYYYYY.
-                        // Note: used with the D3, D9, DA, DB, and DC types.
-                        // Example: D5000000 34540099
-                        if (!skipExecution)
+                // 94000130 FFFB0000
+                // C0000000 00000010
+                // 8453DA0C 00000200
+                // 023D6B28 0009896C
+                // D6000000 00000005
+                // D1000000 00000000
+
+                // The C line, 8 line, 0 line, and D6 line would be terminated.
+                if (cheat_state.loopCount > 0)
+                {
+                    cheat_state.ifStack = cheat_state.storedStack;
+                    cheat_state.ifCount = cheat_state.storedIfCount;
+                    cheat_state.loopCount--;
+                    if (cheat_state.loopCount == 0)
+                    {
+                        cheat_state.loopLine = -1;
+                    }
+                    else
+                    {
+                        if (cheat_state.loopLine != -1)
                         {
-                            cheat_state.data = arg1;
+                            cheat_state.index = cheat_state.loopLine;
                         }
-                        break;
-                    case 0x06:
-                        // D6 Type
-                        // Format: D6000000 XXXXXXXX
-                        // Description: 32bit store and increment by 4.
-                        // Simple: stores the value at address XXXXXXXX and to addresses in increments of 4.
-                        // Note: used with the C, D3, and D9 types.
-                        // Example: D3000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (!Cheat_Write32(processHandle, arg1, cheat_state.data)) return 0;
-                            cheat_state.offset += 4;
-                        }
-                        break;
-                    case 0x07:
-                        // D7 Type
-                        // Format: D7000000 XXXXXXXX
-                        // Description: 16bit store and increment by 2.
-                        // Simple: stores 2 bytes of the value at address XXXXXXXX and to addresses in increments of 2.
-                        // Note: used with the C, D3, and DA types.
-                        // Example: D7000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (!Cheat_Write16(processHandle, arg1, (u16) (cheat_state.data & 0xFFFF))) return 0;
-                            cheat_state.offset += 2;
-                        }
-                        break;
-                    case 0x08:
-                        // D8 Type
-                        // Format: D8000000 XXXXXXXX
-                        // Description: 8bit store and increment by 1.
-                        // Simple: stores 1 byte of the value at address XXXXXXXX and to addresses in increments of 1.
-                        // Note: used with the C, D3, and DB types.
-                        // Example: D8000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            if (!Cheat_Write8(processHandle, arg1, (u8) (cheat_state.data & 0xFF))) return 0;
-                            cheat_state.offset += 1;
-                        }
-                        break;
-                    case 0x09:
-                        // D9 Type
-                        // Format: D9000000 XXXXXXXX
-                        // Description: 32bit load.
-                        // Simple: loads the value from address X.
-                        // Note: used with the D5 and D6 types.
-                        // Example: D9000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            u32 value = 0;
-                            if (!Cheat_Read32(processHandle, arg1, &value)) return 0;
-                            cheat_state.data = value;
-                        }
-                        break;
-                    case 0x0A:
-                        // DA Type
-                        // Format: DA000000 XXXXXXXX
-                        // Description: 16bit load.
-                        // Simple: loads 2 bytes from address X.
-                        // Note: used with the D5 and D7 types.
-                        // Example: DA000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            u16 value = 0;
-                            if (!Cheat_Read16(processHandle, arg1, &value)) return 0;
-                            cheat_state.data = value;
-                        }
-                        break;
-                    case 0x0B:
-                        // DB Type
-                        // Format: DB000000 XXXXXXXX
-                        // Description: 8bit load.
-                        // Simple: loads 1 byte from address X.
-                        // Note: used with the D5 and D8 types.
-                        // Example: DB000000 023D6B28
-                        if (!skipExecution)
-                        {
-                            u8 value = 0;
-                            if (!Cheat_Read8(processHandle, arg1, &value)) return 0;
-                            cheat_state.data = value;
-                        }
-                        break;
-                    case 0x0C:
-                        // DC Type
-                        // Format: DC000000 VVVVVVVV
-                        // Description: 32bit store and increment by V.
-                        // Simple: stores the value at address(es) before it and to addresses in increments of V.
-                        // Note: used with the C, D3, D5, D9, D8, DB types.
-                        // Example: DC000000 00000100
-                        if (!skipExecution)
-                        {
-                            cheat_state.offset += arg1;
-                        }
-                        break;
-                    case 0x0D:
-                        // DD Type
+                    }
+                }
+                break;
+            case 0xD2:
+                // D2 Type
+                // Format: D2000000 00000000
+                // Description: ends all conditionals/repeats before it and sets offset and stored to zero.
+                // Simple: ends all lines.
+                // Example:
+
+                // 94000130 FEEF0000
+                // C0000000 00000010
+                // 8453DA0C 00000200
+                // 023D6B28 0009896C
+                // D6000000 00000005
+                // D2000000 00000000
+
+                // All lines would terminate.
+                if (cheat_state.loopCount > 0)
+                {
+                    cheat_state.loopCount--;
+                    if (cheat_state.loopCount == 0)
                     {
-                        u32 newSkip;
-                        if (arg1 == 0 || (HID_PAD & arg1) == arg1)
-                        {
-                            newSkip = 0;
-                        }
-                        else
+                        cheat_state.data = 0;
+                        cheat_state.offset = 0;
+                        cheat_state.loopLine = -1;
+
+                        cheat_state.ifStack = 0;
+                        cheat_state.ifCount = 0;
+                    }
+                    else
+                    {
+                        if (cheat_state.loopLine != -1)
                         {
-                            newSkip = 1;
+                            cheat_state.index = cheat_state.loopLine;
                         }
-
-                        cheat_state.ifStack <<= 1;
-                        cheat_state.ifStack |= ((newSkip | skipExecution) & 0x1);
-                        cheat_state.ifCount++;
                     }
-                        break;
-                    default:
-                        return 0;
+                }
+                else
+                {
+                    cheat_state.data = 0;
+                    cheat_state.offset = 0;
+                    cheat_state.ifStack = 0;
+                    cheat_state.ifCount = 0;
+                }
+                break;
+            case 0xD3:
+                // D3 Type
+                // Format: D3000000 XXXXXXXX
+                // Description: sets offset.
+                // Simple: loads the address X so that lines after can modify the value at address X.
+                // Note: used with the D4, D5, D6, D7, D8, and DC types.
+                // Example: D3000000 023D6B28
+                if (!skipExecution)
+                {
+                    cheat_state.offset = op->value;
+                }
+                break;
+            case 0xD4:
+                // D4 Type
+                // Format: D4000000 YYYYYYYY
+                // Description: adds to the stored address' value.
+                // Simple: adds to the value at the address defined by lines D3, D9, DA, and DB.
+                // Note: used with the D3, D9, DA, DB, DC types.
+                // Example: D4000000 00000025
+                if (!skipExecution)
+                {
+                    cheat_state.data += op->value;
+                }
+                break;
+            case 0xD5:
+                // D5 Type
+                // Format: D5000000 YYYYYYYY
+                // Description: sets the stored address' value.
+                // Simple: makes the value at the address defined by lines D3, D9, DA, and DB to YYYYYYYY.
+                // Note: used with the D3, D9, DA, DB, and DC types.
+                // Example: D5000000 34540099
+                if (!skipExecution)
+                {
+                    cheat_state.data = op->value;
+                }
+                break;
+            case 0xD6:
+                // D6 Type
+                // Format: D6000000 XXXXXXXX
+                // Description: 32bit store and increment by 4.
+                // Simple: stores the value at address XXXXXXXX and to addresses in increments of 4.
+                // Note: used with the C, D3, and D9 types.
+                // Example: D3000000 023D6B28
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write32(processHandle, op->value, cheat_state.data)) return 0;
+                    cheat_state.offset += 4;
+                }
+                break;
+            case 0xD7:
+                // D7 Type
+                // Format: D7000000 XXXXXXXX
+                // Description: 16bit store and increment by 2.
+                // Simple: stores 2 bytes of the value at address XXXXXXXX and to addresses in increments of 2.
+                // Note: used with the C, D3, and DA types.
+                // Example: D7000000 023D6B28
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write16(processHandle, op->value, (u16) (cheat_state.data & 0xFFFF))) return 0;
+                    cheat_state.offset += 2;
+                }
+                break;
+            case 0xD8:
+                // D8 Type
+                // Format: D8000000 XXXXXXXX
+                // Description: 8bit store and increment by 1.
+                // Simple: stores 1 byte of the value at address XXXXXXXX and to addresses in increments of 1.
+                // Note: used with the C, D3, and DB types.
+                // Example: D8000000 023D6B28
+                if (!skipExecution)
+                {
+                    if (!Cheat_Write8(processHandle, op->value, (u8) (cheat_state.data & 0xFF))) return 0;
+                    cheat_state.offset += 1;
                 }
                 break;
+            case 0xD9:
+                // D9 Type
+                // Format: D9000000 XXXXXXXX
+                // Description: 32bit load.
+                // Simple: loads the value from address X.
+                // Note: used with the D5 and D6 types.
+                // Example: D9000000 023D6B28
+                if (!skipExecution)
+                {
+                    u32 value = 0;
+                    if (!Cheat_Read32(processHandle, op->value, &value)) return 0;
+                    cheat_state.data = value;
+                }
+                break;
+            case 0xDA:
+                // DA Type
+                // Format: DA000000 XXXXXXXX
+                // Description: 16bit load.
+                // Simple: loads 2 bytes from address X.
+                // Note: used with the D5 and D7 types.
+                // Example: DA000000 023D6B28
+                if (!skipExecution)
+                {
+                    u16 value = 0;
+                    if (!Cheat_Read16(processHandle, op->value, &value)) return 0;
+                    cheat_state.data = value;
+                }
+                break;
+            case 0xDB:
+                // DB Type
+                // Format: DB000000 XXXXXXXX
+                // Description: 8bit load.
+                // Simple: loads 1 byte from address X.
+                // Note: used with the D5 and D8 types.
+                // Example: DB000000 023D6B28
+                if (!skipExecution)
+                {
+                    u8 value = 0;
+                    if (!Cheat_Read8(processHandle, op->value, &value)) return 0;
+                    cheat_state.data = value;
+                }
+                break;
+            case 0xDC:
+                // DC Type
+                // Format: DC000000 VVVVVVVV
+                // Description: 32bit store and increment by V.
+                // Simple: stores the value at address(es) before it and to addresses in increments of V.
+                // Note: used with the C, D3, D5, D9, D8, DB types.
+                // Example: DC000000 00000100
+                if (!skipExecution)
+                {
+                    cheat_state.offset += op->value;
+                }
+                break;
+            case 0xDD:
+                // DD Type
+                if (Cheat_PushConditional(op, skipExecution || !(op->value == 0 || (HID_PAD & op->value) == op->value))) continue;
+                break;
             case 0xE:
                 // E Type
                 // Format:
@@ -777,22 +904,14 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
                 // YYYYYYYY YYYYYYYY
 
                 // Description: writes Y to X for U bytes.
-
-            {
-                u32 beginOffset = (arg0 & 0x0FFFFFFF);
-                u32 count = arg1;
-                cheat_state.typeELine = cheat_state.index;
-                cheat_state.typeEIdx = 7;
-                for (u32 i = 0; i < count; i++)
+                if (!skipExecution)
                 {
-                    u8 byte = Cheat_GetNextTypeE(cheat);
-                    if (!skipExecution)
+                    for (u32 i = 0; i < op->value; i++)
                     {
-                        if (!Cheat_Write8(processHandle, beginOffset + i, byte)) return 0;
+                        if (!Cheat_Write8(processHandle, op->address + i, Cheat_GetTypeEByte(op, i))) return 0;
                     }
                 }
-                cheat_state.index = cheat_state.typeELine;
-            }
+                cheat_state.index = op->target;
                 break;
             default:
                 return 0;
@@ -802,6 +921,15 @@ static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription*
     return 1;
 }
 
+static u32 Cheat_ApplyCheat(const Handle processHandle, const CheatDescription* const cheat)
+{
+    Cheat_ResetMemoryCache();
+
+    // Whatever was written before a failing line still lands, like it did when every write was a syscall
+    u32 valid = Cheat_RunOps(processHandle, cheat);
+    return Cheat_FlushWrites(processHandle) ? valid : 0;
+}
+
 static void Cheat_EatEvents(Handle debug)
 {
     DebugEventInfo info;
@@ -820,101 +948,81 @@ static void Cheat_EatEvents(Handle debug)
     }
 }
 
-static Result Cheat_MapMemoryAndApplyCheat(u32 pid, CheatDescription* const cheat)
+static Result Cheat_OpenFile(CheatFileReader* reader, const char* path)
 {
-    Handle processHandle;
-    Handle debugHandle;
-    Result res;
-    res = svcOpenProcess(&processHandle, pid);
+    u64 fileSize = 0;
+    Result res = IFile_Open(&reader->file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ);
     if (R_SUCCEEDED(res))
     {
-        res = svcDebugActiveProcess(&debugHandle, pid);
-        if (R_SUCCEEDED(res))
-        {
-            Cheat_EatEvents(debugHandle);
-            cheat->valid = Cheat_ApplyCheat(debugHandle, cheat);
-
-            svcCloseHandle(debugHandle);
-            svcCloseHandle(processHandle);
-            cheat->active = 1;
-        }
-        else
+        res = IFile_GetSize(&reader->file, &fileSize);
+        if (R_FAILED(res))
         {
-            svcCloseHandle(processHandle);
+            IFile_Close(&reader->file);
         }
     }
-    else
-    {
-        sprintf(failureReason, "Open process failed");
-    }
-    return res;
-}
 
-static CheatDescription* Cheat_AllocCheat()
-{
-    CheatDescription* cheat;
-    if (cheatCount == 0)
-    {
-        cheat = (CheatDescription*) cheatBuffer;
-    }
-    else
-    {
-        CheatDescription* prev = cheats[cheatCount - 1];
-        cheat = (CheatDescription *) ((u8*) (prev) + sizeof(CheatDescription) + sizeof(u64) * (prev->codesCount));
-    }
-    cheat->active = 0;
-    cheat->valid = 1;
-    cheat->codesCount = 0;
-    cheat->keyActivated = 0;
-    cheat->keyCombo = 0;
-    cheat->name[0] = '\0';
-
-    cheats[cheatCount] = cheat;
-    cheatCount++;
-    return cheat;
+    reader->fileSize = R_SUCCEEDED(res) && fileSize < 0xFFFFFFFF ? (u32) fileSize : 0;
+    reader->end = reader->fileSize;
+    reader->bufStart = 0;
+    reader->bufPos = 0;
+    reader->bufLen = 0;
+    return res;
 }
 
-static void Cheat_AddCode(CheatDescription* cheat, u64 code)
+static void Cheat_SeekFile(CheatFileReader* reader, u32 offset, u32 size)
 {
-    if (cheat)
-    {
-        cheat->codes[cheat->codesCount] = code;
-        (cheat->codesCount)++;
-    }
+    reader->end = (offset < reader->fileSize && size < reader->fileSize - offset) ? offset + size : reader->fileSize;
+    reader->bufStart = offset < reader->end ? offset : reader->end;
+    reader->bufPos = 0;
+    reader->bufLen = 0;
 }
 
-static Result Cheat_ReadLine(char* line)
+static s32 Cheat_ReadLine(CheatFileReader* reader, char* line, u32* lineOffset)
 {
-    Result res = 0;
-
-    char c = '\0';
     u32 idx = 0;
-    while (R_SUCCEEDED(res))
+    *lineOffset = reader->bufStart + reader->bufPos;
+
+    while (true)
     {
-        c = cheatFileBuffer[cheatFilePos++];
-        res = c ? 0 : -1;
-        if (R_SUCCEEDED(res) && c != '\0')
+        if (reader->bufPos == reader->bufLen)
         {
-            if (c == '\n' || c == '\r' || idx >= 1023)
+            // IFile_Read never returns short of the requested size, so never read past the end of the file
+            u32 start = reader->bufStart + reader->bufLen;
+            u32 size = reader->end - start;
+            u64 total = 0;
+
+            reader->bufStart = start;
+            reader->bufPos = 0;
+            reader->bufLen = 0;
+            reader->file.pos = start;
+            if (size > sizeof(cheatFileBuffer))
             {
-                line[idx++] = '\0';
-                return idx;
+                size = sizeof(cheatFileBuffer);
             }
-            else
+            if (size != 0 && R_SUCCEEDED(IFile_Read(&reader->file, &total, cheatFileBuffer, size)))
             {
-                line[idx++] = c;
+                reader->bufLen = (u32) total;
             }
-        }
-        else
-        {
-            if (idx > 0)
+
+            if (reader->bufLen == 0)
             {
-                line[idx++] = '\0';
+                if (idx == 0)
+                {
+                    return -1;
+                }
+                line[idx] = '\0';
                 return idx;
             }
         }
+
+        char c = cheatFileBuffer[reader->bufPos++];
+        if (c == '\n' || c == '\r' || idx >= 1023)
+        {
+            line[idx] = '\0';
+            return idx;
+        }
+        line[idx++] = c;
     }
-    return res;
 }
 
 static bool Cheat_IsCodeLine(const char *line)
@@ -998,99 +1106,336 @@ static u64 Cheat_GetCode(const char *line)
     return tmp;
 }
 
-static void Cheat_LoadCheatsIntoMemory(u64 titleId)
+static CheatDescription* Cheat_AllocCheat(void)
 {
-    cheatCount = 0;
-    cheatTitleInfo = titleId;
-    hasKeyActivated = 0;
-
-    char path[64] = { 0 };
-    sprintf(path, "/luma/titles/%016llX/cheats.txt", titleId);
-
-    IFile file;
-
-    if (R_FAILED(IFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
-    {
-        // OK, let's try another source
-        sprintf(path, "/cheats/%016llX.txt", titleId);
-        if (R_FAILED(IFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ))) return;
-    };
-
-    u64 fileLen = 0;
-    IFile_GetSize(&file, &fileLen);
-    if (fileLen > 16383)
+    if (cheatCount >= CHEATS_MAX)
     {
-        fileLen = 16383;
+        return NULL;
     }
 
-    u64 total;
-    IFile_Read(&file, &total, cheatFileBuffer, fileLen);
-    IFile_Close(&file);
-    for (int i = fileLen; i < 16384; i++)
-    {
-        cheatFileBuffer[i] = 0;
-    }
+    CheatDescription* cheat = &cheats[cheatCount++];
+    memset(cheat, 0, sizeof(CheatDescription));
+    cheat->valid = 1;
+    return cheat;
+}
 
+static void Cheat_BuildIndex(CheatFileReader* reader)
+{
     char line[1024] = { 0 };
-    Result res = 0;
-    CheatDescription* cheat = 0;
-    cheatFilePos = 0;
-    do
+    CheatDescription* cheat = NULL;
+    u32 lineOffset;
+    s32 lineLen;
+
+    Cheat_SeekFile(reader, 0, reader->fileSize);
+    while ((lineLen = Cheat_ReadLine(reader, line, &lineOffset)) >= 0)
     {
-        res = Cheat_ReadLine(line);
-        if (R_SUCCEEDED(res))
+        if (!lineLen)
         {
-            s32 lineLen = strnlen(line, 1023);
-            if (!lineLen)
-            {
-                continue;
-            }
-            if (line[0] == '#')
-            {
-                continue;
-            }
-            if (Cheat_IsCodeLine(line))
+            continue;
+        }
+        if (line[0] == '#')
+        {
+            continue;
+        }
+        if (Cheat_IsCodeLine(line))
+        {
+            if (cheat)
             {
-                if (cheat)
+                u64 tmp = Cheat_GetCode(line);
+                if (cheat->codesCount == 0)
+                {
+                    cheat->fileOffset = lineOffset;
+                }
+                cheat->fileSize = lineOffset + lineLen - cheat->fileOffset;
+                cheat->codesCount++;
+                if (((tmp >> 32) & 0xFFFFFFFF) == 0xDD000000)
                 {
-                    u64 tmp = Cheat_GetCode(line);
-                    Cheat_AddCode(cheat, tmp);
-                    if (((tmp >> 32) & 0xFFFFFFFF) == 0xDD000000)
+                    if (tmp & 0xFFFFFFFF)
                     {
-                        if (tmp & 0xFFFFFFFF)
-                        {
-                            // Not empty key code
-                            cheat->keyCombo |= (tmp & 0xFFF);
-                            cheat->keyActivated = 1;
-                        }
+                        // Not empty key code
+                        cheat->keyCombo |= (tmp & 0xFFF);
+                        cheat->keyActivated = 1;
                     }
                 }
             }
-            else
+        }
+        else
+        {
+            if (!cheat || cheat->codesCount > 0)
             {
+                // Add new cheat only if previous has body. In other case just rewrite it's name
+                cheat = Cheat_AllocCheat();
                 if (!cheat)
                 {
-                    cheat = Cheat_AllocCheat();
-                }
-                else
-                {
-                    if (cheat->codesCount > 0)
-                    {
-                        // Add new cheat only if previous has body. In other case just rewrite it's name
-                        cheat = Cheat_AllocCheat();
-                    }
+                    break;
                 }
-                strncpy(cheat->name, line, 39);
             }
+            strncpy(cheat->name, line, 39);
         }
-    } while (R_SUCCEEDED(res));
+    }
 
-    if ((cheatCount > 0) && (cheats[cheatCount - 1]->codesCount == 0))
+    if ((cheatCount > 0) && (cheats[cheatCount - 1].codesCount == 0))
     {
         cheatCount--; // Remove last empty cheat
     }
 }
 
+static u64 Cheat_GetFileTimestamp(const char* path)
+{
+    FS_Archive archive;
+    u16 utf16Path[64];
+    u64 timestamp = 0;
+    u32 len;
+
+    for (len = 0; path[len] != '\0' && len < 63; len++)
+    {
+        utf16Path[len] = path[len];
+    }
+    utf16Path[len++] = 0;
+
+    if (R_SUCCEEDED(FSUSER_OpenArchive(&archive, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""))))
+    {
+        if (R_FAILED(FSUSER_ControlArchive(archive, ARCHIVE_ACTION_GET_TIMESTAMP, utf16Path, len * sizeof(u16), &timestamp, sizeof(timestamp))))
+        {
+            timestamp = 0;
+        }
+        FSUSER_CloseArchive(archive);
+    }
+    return timestamp;
+}
+
+static bool Cheat_LoadIndex(const char* path, u32 fileSize, u64 timestamp)
+{
+    IFile file;
+    CheatIndexHeader header;
+    u64 total;
+    bool ret = false;
+
+    if (R_FAILED(IFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_READ)))
+    {
+        return false;
+    }
+
+    if (R_SUCCEEDED(IFile_GetSize(&file, &total)) && total >= sizeof(CheatIndexHeader) &&
+        R_SUCCEEDED(IFile_Read(&file, &total, &header, sizeof(CheatIndexHeader))) &&
+        header.magic == CHEAT_INDEX_MAGIC && header.fileSize == fileSize && header.timestamp == timestamp &&
+        header.nbCheats <= CHEATS_MAX && file.size == sizeof(CheatIndexHeader) + header.nbCheats * sizeof(CheatIndexEntry))
+    {
+        CheatIndexEntry* entries = (CheatIndexEntry*) cheatFileBuffer;
+        u32 perChunk = sizeof(cheatFileBuffer) / sizeof(CheatIndexEntry);
+
+        ret = true;
+        for (u32 i = 0; ret && i < header.nbCheats; i += perChunk)
+        {
+            u32 nb = header.nbCheats - i < perChunk ? header.nbCheats - i : perChunk;
+            ret = R_SUCCEEDED(IFile_Read(&file, &total, entries, nb * sizeof(CheatIndexEntry)));
+            for (u32 j = 0; ret && j < nb; j++)
+            {
+                CheatDescription* cheat = Cheat_AllocCheat();
+                cheat->fileOffset = entries[j].fileOffset;
+                cheat->fileSize = entries[j].fileSize;
+                cheat->codesCount = entries[j].codesCount;
+                cheat->keyCombo = entries[j].keyCombo;
+                cheat->keyActivated = entries[j].keyActivated;
+                memcpy(cheat->name, entries[j].name, sizeof(cheat->name));
+                cheat->name[sizeof(cheat->name) - 1] = '\0';
+            }
+        }
+
+        if (!ret)
+        {
+            cheatCount = 0;
+        }
+    }
+
+    IFile_Close(&file);
+    return ret;
+}
+
+static void Cheat_StoreIndex(const char* path, u32 fileSize, u64 timestamp)
+{
+    IFile file;
+    CheatIndexHeader header = {
+        .magic = CHEAT_INDEX_MAGIC,
+        .nbCheats = cheatCount,
+        .fileSize = fileSize,
+        .timestamp = timestamp,
+    };
+    u32 nbCheats = header.nbCheats;
+    u64 total;
+    Result res;
+
+    if (R_FAILED(IFile_Open(&file, ARCHIVE_SDMC, fsMakePath(PATH_EMPTY, ""), fsMakePath(PATH_ASCII, path), FS_OPEN_CREATE | FS_OPEN_WRITE)))
+    {
+        return;
+    }
+
+    res = FSFILE_SetSize(file.handle, sizeof(CheatIndexHeader) + nbCheats * sizeof(CheatIndexEntry));
+    if (R_SUCCEEDED(res))
+    {
+        res = IFile_Write(&file, &total, &header, sizeof(CheatIndexHeader), 0);
+    }
+
+    CheatIndexEntry* entries = (CheatIndexEntry*) cheatFileBuffer;
+    u32 perChunk = sizeof(cheatFileBuffer) / sizeof(CheatIndexEntry);
+    for (u32 i = 0; R_SUCCEEDED(res) && i < nbCheats; i += perChunk)
+    {
+        u32 nb = nbCheats - i < perChunk ? nbCheats - i : perChunk;
+        for (u32 j = 0; j < nb; j++)
+        {
+            const CheatDescription* cheat = &cheats[i + j];
+            entries[j].fileOffset = cheat->fileOffset;
+            entries[j].fileSize = cheat->fileSize;
+            entries[j].codesCount = cheat->codesCount;
+            entries[j].keyCombo = cheat->keyCombo;
+            entries[j].keyActivated = cheat->keyActivated;
+            memcpy(entries[j].name, cheat->name, sizeof(entries[j].name));
+        }
+        res = IFile_Write(&file, &total, entries, nb * sizeof(CheatIndexEntry), 0);
+    }
+
+    // A partial index would otherwise be trusted next time
+    if (R_FAILED(res))
+    {
+        FSFILE_SetSize(file.handle, 0);
+    }
+    IFile_Close(&file);
+}
+
+static void Cheat_LoadCheatsIntoMemory(u64 titleId)
+{
+    cheatCount = 0;
+    cheatOpsCount = 0;
+    cheatTitleInfo = titleId;
+    hasKeyActivated = 0;
+
+    CheatFileReader reader;
+
+    sprintf(cheatFilePath, "/luma/titles/%016llX/cheats.txt", titleId);
+    if (R_FAILED(Cheat_OpenFile(&reader, cheatFilePath)))
+    {
+        // OK, let's try another source
+        sprintf(cheatFilePath, "/cheats/%016llX.txt", titleId);
+        if (R_FAILED(Cheat_OpenFile(&reader, cheatFilePath))) return;
+    }
+
+    // The index sits next to the cheat file, as <name>.idx
+    char indexPath[64];
+    u32 pathLen = strlen(cheatFilePath);
+    strcpy(indexPath, cheatFilePath);
+    strcpy(indexPath + pathLen - 3, "idx");
+
+    u64 timestamp = Cheat_GetFileTimestamp(cheatFilePath);
+    if (timestamp == 0 || !Cheat_LoadIndex(indexPath, reader.fileSize, timestamp))
+    {
+        Cheat_BuildIndex(&reader);
+        if (timestamp != 0)
+        {
+            Cheat_StoreIndex(indexPath, reader.fileSize, timestamp);
+        }
+    }
+
+    IFile_Close(&reader.file);
+}
+
+static bool Cheat_LoadCodes(CheatDescription* const cheat)
+{
+    CheatFileReader reader;
+    char line[1024] = { 0 };
+    u32 lineOffset;
+    s32 lineLen;
+    u32 codesCount = 0;
+
+    if (R_FAILED(Cheat_OpenFile(&reader, cheatFilePath)))
+    {
+        return false;
+    }
+
+    Cheat_SeekFile(&reader, cheat->fileOffset, cheat->fileSize);
+    while (codesCount < cheat->codesCount && (lineLen = Cheat_ReadLine(&reader, line, &lineOffset)) >= 0)
+    {
+        if (Cheat_IsCodeLine(line))
+        {
+            cheatCodes[codesCount++] = Cheat_GetCode(line);
+        }
+    }
+    IFile_Close(&reader.file);
+
+    // The file changed under our feet
+    if (codesCount != cheat->codesCount)
+    {
+        return false;
+    }
+    return true;
+}
+
+static Result Cheat_Prepare(CheatDescription* const cheat)
+{
+    if (cheat->ops)
+    {
+        return 0;
+    }
+
+    Result res = 0;
+    if (cheat->codesCount > sizeof(cheatCodes) / sizeof(u64))
+    {
+        sprintf(failureReason, "Truco demasiado largo (%lu lineas)", cheat->codesCount);
+        res = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+    }
+    else if (!Cheat_LoadCodes(cheat))
+    {
+        sprintf(failureReason, "No se pudo leer el truco, reabre el menu");
+        res = MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_INVALID_SIZE);
+    }
+    else if (!Cheat_Compile(cheat, cheatCodes))
+    {
+        // Even with only the enabled cheats left in the pool
+        sprintf(failureReason, "Demasiadas lineas en los trucos activos");
+        res = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+    }
+
+    if (R_FAILED(res))
+    {
+        cheat->valid = 0;
+    }
+    return res;
+}
+
+static Result Cheat_MapMemoryAndApplyCheat(u32 pid, CheatDescription* const cheat)
+{
+    Handle processHandle;
+    Handle debugHandle;
+    Result res = Cheat_Prepare(cheat);
+    if (R_FAILED(res))
+    {
+        return res;
+    }
+
+    res = svcOpenProcess(&processHandle, pid);
+    if (R_SUCCEEDED(res))
+    {
+        res = svcDebugActiveProcess(&debugHandle, pid);
+        if (R_SUCCEEDED(res))
+        {
+            Cheat_EatEvents(debugHandle);
+            cheat->valid = Cheat_ApplyCheat(debugHandle, cheat);
+
+            svcCloseHandle(debugHandle);
+            svcCloseHandle(processHandle);
+            cheat->active = 1;
+        }
+        else
+        {
+            svcCloseHandle(processHandle);
+        }
+    }
+    else
+    {
+        sprintf(failureReason, "Open process failed");
+    }
+    return res;
+}
+
 static u32 Cheat_GetCurrentPID(u64* titleId)
 {
     s32 processAmount = Cheats_FetchProcessInfo();
@@ -1120,7 +1465,42 @@ static u32 Cheat_GetCurrentPID(u64* titleId)
     }
 }
 
-void Cheat_ApplyCheats(void) 
+static Handle cheatProcessHandle = 0;
+static u32 cheatProcessPid = 0xFFFFFFFF;
+static u64 cheatProcessTitleId = 0;
+
+static void Cheat_ReleaseProcess(void)
+{
+    if (cheatProcessHandle != 0)
+    {
+        svcCloseHandle(cheatProcessHandle);
+        cheatProcessHandle = 0;
+    }
+    cheatProcessPid = 0xFFFFFFFF;
+    cheatProcessTitleId = 0;
+}
+
+static u32 Cheat_GetCachedPID(u64* titleId)
+{
+    // The process handle is kept open for as long as the title runs, and gets signaled when it terminates
+    if (cheatProcessHandle != 0 && R_FAILED(svcWaitSynchronization(cheatProcessHandle, 0)))
+    {
+        *titleId = cheatProcessTitleId;
+        return cheatProcessPid;
+    }
+
+    Cheat_ReleaseProcess();
+
+    u32 pid = Cheat_GetCurrentPID(titleId);
+    if (pid != 0xFFFFFFFF && R_SUCCEEDED(svcOpenProcess(&cheatProcessHandle, pid)))
+    {
+        cheatProcessPid = pid;
+        cheatProcessTitleId = *titleId;
+    }
+    return pid;
+}
+
+void Cheat_ApplyCheats(void)
 {
     if (!cheatCount)
     {
@@ -1128,7 +1508,7 @@ void Cheat_ApplyCheats(void)
     }
 
     u64 titleId = 0;
-    u32 pid = Cheat_GetCurrentPID(&titleId);
+    u32 pid = Cheat_GetCachedPID(&titleId);
 
     if (!titleId)
     {
@@ -1144,24 +1524,77 @@ void Cheat_ApplyCheats(void)
         return;
     }
 
+    // Every active cheat is applied within a single debugger attach, which is what stalls the title
+    Handle debugHandle = 0;
     u32 keys = HID_PAD & 0xFFF;
     for (int i = 0; i < cheatCount; i++)
     {
-        if (cheats[i]->active && !(cheats[i]->keyActivated)) 
+        CheatDescription* cheat = &cheats[i];
+        if (!cheat->active || (cheat->keyActivated && (cheat->keyCombo & keys) != keys))
+        {
+            continue;
+        }
+
+        if (R_FAILED(Cheat_Prepare(cheat)))
+        {
+            continue;
+        }
+
+        if (debugHandle == 0)
+        {
+            if (R_FAILED(svcDebugActiveProcess(&debugHandle, pid)))
+            {
+                debugHandle = 0;
+                break;
+            }
+            Cheat_EatEvents(debugHandle);
+        }
+        cheat->valid = Cheat_ApplyCheat(debugHandle, cheat);
+    }
+
+    if (debugHandle != 0)
+    {
+        svcCloseHandle(debugHandle);
+    }
+}
+
+static MyThread cheatsThread;
+static u8 ALIGN(8) cheatsThreadStack[THREAD_STACK_SIZE];
+
+MyThread *cheatsCreateThread(void)
+{
+    RecursiveLock_Init(&cheatsLock);
+    if(R_FAILED(MyThread_Create(&cheatsThread, cheatsThreadMain, cheatsThreadStack, THREAD_STACK_SIZE, 0x3F, CORE_SYSTEM)))
+        svcBreak(USERBREAK_PANIC);
+    return &cheatsThread;
+}
+
+void cheatsThreadMain(void)
+{
+    while (!terminationRequest)
+    {
+        RecursiveLock_Lock(&cheatsLock);
+        // The menu may have cached a title with no cheats: drop its handle once it exits, so its KProcess can go away
+        if (cheatProcessHandle != 0 && R_SUCCEEDED(svcWaitSynchronization(cheatProcessHandle, 0)))
         {
-            Cheat_MapMemoryAndApplyCheat(pid, cheats[i]);
-			        }  
-        else if (cheats[i]->active && cheats[i]->keyActivated && (cheats[i]->keyCombo & keys) == keys) 
-        { 
-            Cheat_MapMemoryAndApplyCheat(pid, cheats[i]); 
+            Cheat_ReleaseProcess();
         }
+        Cheat_ApplyCheats();
+        RecursiveLock_Unlock(&cheatsLock);
+
+        svcSleepThread(CHEATS_APPLY_PERIOD);
     }
+
+    Cheat_ReleaseProcess();
 }
 
 void RosalinaMenu_Cheats(void)
 {
+    // Cheats aren't applied in the background while their menu is open
+    RecursiveLock_Lock(&cheatsLock);
+
     u64 titleId = 0;
-    u32 pid = Cheat_GetCurrentPID(&titleId);
+    u32 pid = Cheat_GetCachedPID(&titleId);
 
     if (titleId != 0)
     {
@@ -1215,11 +1648,11 @@ void RosalinaMenu_Cheats(void)
                 {
                     char buf[65] = { 0 };
                     s32 j = page * CHEATS_PER_MENU_PAGE + i;
-                    const char * checkbox = (cheats[j]->active ? "(x) " : "( ) ");
-                    const char * keyAct = (cheats[j]->keyActivated ? "*" : " ");
-                    sprintf(buf, "%s%s%s", checkbox, keyAct, cheats[j]->name);
+                    const char * checkbox = (cheats[j].active ? "(x) " : "( ) ");
+                    const char * keyAct = (cheats[j].keyActivated ? "*" : " ");
+                    sprintf(buf, "%s%s%s", checkbox, keyAct, cheats[j].name);
 
-                    Draw_DrawString(30, 30 + i * SPACING_Y, cheats[j]->valid ? COLOR_WHITE : COLOR_RED, buf);
+                    Draw_DrawString(30, 30 + i * SPACING_Y, cheats[j].valid ? COLOR_WHITE : COLOR_RED, buf);
                     Draw_DrawCharacter(10, 30 + i * SPACING_Y, COLOR_TITLE, j == selected ? '>' : ' ');
                 }
             }
@@ -1244,18 +1677,18 @@ void RosalinaMenu_Cheats(void)
                 break;
             else if ((pressed & BUTTON_A) && R_SUCCEEDED(r))
             {
-                if (cheats[selected]->active)
+                if (cheats[selected].active)
                 {
-                    cheats[selected]->active = 0;
+                    cheats[selected].active = 0;
                 }
                 else
                 {
-                    r = Cheat_MapMemoryAndApplyCheat(pid, cheats[selected]);
+                    r = Cheat_MapMemoryAndApplyCheat(pid, &cheats[selected]);
                 }
                 hasKeyActivated = 0;
                 for (int i = 0; i < cheatCount; i++)
                 {
-                    if (cheats[i]->active && cheats[i]->keyActivated)
+                    if (cheats[i].active && cheats[i].keyActivated)
                     {
                         hasKeyActivated = 1;
                         break;
@@ -1286,4 +1719,5 @@ void RosalinaMenu_Cheats(void)
         } while (!terminationRequest);
     }
 
+    RecursiveLock_Unlock(&cheatsLock);
 }
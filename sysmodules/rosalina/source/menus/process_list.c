@@ -37,6 +37,7 @@
 #include "minisoc.h"
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <stdlib.h>
 
 typedef struct ProcessInfo
 {
@@ -46,7 +47,18 @@ typedef struct ProcessInfo
     bool isZombie;
 } ProcessInfo;
 
+typedef struct ServiceIpcStats
+{
+    char name[9];
+    u32 nbRequests;
+    u32 maxTicks;
+    u64 totalTicks;
+} ServiceIpcStats;
+
+#define IPC_STATS_NAME_SLOTS    0x200 // size of the kernel's session name index
+
 static ProcessInfo infos[0x40] = {0}, infosPrev[0x40] = {0};
+static ServiceIpcStats ipcStats[IPC_STATS_NAME_SLOTS];
 extern GDBServer gdbServer;
 
 static inline int ProcessListMenu_FormatInfoLine(char *out, const ProcessInfo *info)
@@ -573,6 +585,87 @@ static void ProcessListMenu_MemoryViewer(const ProcessInfo *info)
     }
 }
 
+static int ProcessListMenu_CompareIpcStats(const void *a, const void *b)
+{
+    u64 ta = ((const ServiceIpcStats *)a)->totalTicks, tb = ((const ServiceIpcStats *)b)->totalTicks;
+    return ta < tb ? 1 : (ta > tb ? -1 : 0);
+}
+
+static u32 ProcessListMenu_FetchIpcStats(void)
+{
+    u32 n = 0;
+    for(u32 slot = 0; slot < IPC_STATS_NAME_SLOTS; slot++)
+    {
+        s64 out;
+        if(R_FAILED(svcGetSystemInfo(&out, 0x10004, slot << 2)))
+            continue;
+
+        ServiceIpcStats *stats = &ipcStats[n++];
+        memcpy(stats->name, &out, 8);
+        stats->name[8] = 0;
+        svcGetSystemInfo(&out, 0x10004, (slot << 2) | 1);
+        stats->nbRequests = (u32)out;
+        svcGetSystemInfo(&out, 0x10004, (slot << 2) | 2);
+        stats->totalTicks = (u64)out;
+        svcGetSystemInfo(&out, 0x10004, (slot << 2) | 3);
+        stats->maxTicks = (u32)out;
+    }
+
+    qsort(ipcStats, n, sizeof(ServiceIpcStats), ProcessListMenu_CompareIpcStats);
+    return n;
+}
+
+static void ProcessListMenu_IpcHotServices(void)
+{
+    // Counting requests has a cost, only do it while this screen is shown
+    svcKernelSetState(0x10007, 3);
+
+    Draw_Lock();
+    Draw_ClearFramebuffer();
+    Draw_FlushFramebuffer();
+    Draw_Unlock();
+
+    do
+    {
+        u32 n = ProcessListMenu_FetchIpcStats();
+
+        Draw_Lock();
+        Draw_DrawString(10, 10, COLOR_TITLE, "Servicios IPC mas usados");
+        Draw_DrawFormattedString(30, 30, COLOR_WHITE, "%-8s  %10s  %10s  %10s", "Nombre", "Peticiones", "Media (us)", "Max (us)");
+
+        for(u32 i = 0; i < PROCESSES_PER_MENU_PAGE - 2; i++)
+        {
+            if(i < n && ipcStats[i].nbRequests != 0)
+            {
+                const ServiceIpcStats *stats = &ipcStats[i];
+                u32 avgUs = (u32)(stats->totalTicks / stats->nbRequests * 1000000ULL / SYSCLOCK_ARM11);
+                u32 maxUs = (u32)((u64)stats->maxTicks * 1000000ULL / SYSCLOCK_ARM11);
+                Draw_DrawFormattedString(30, 30 + (i + 1) * SPACING_Y, COLOR_WHITE, "%-8s  %10lu  %10lu  %10lu", stats->name, stats->nbRequests, avgUs, maxUs);
+            }
+            else
+                Draw_DrawFormattedString(30, 30 + (i + 1) * SPACING_Y, COLOR_WHITE, "%44s", "");
+        }
+
+        Draw_DrawString(10, SCREEN_BOT_HEIGHT - 20, COLOR_TITLE, "X: reiniciar contadores  B: volver");
+        Draw_FlushFramebuffer();
+        Draw_Unlock();
+
+        u32 pressed = waitInputWithTimeout(1000);
+        if(pressed & BUTTON_B)
+            break;
+        else if(pressed & BUTTON_X)
+            svcKernelSetState(0x10007, 3);
+    }
+    while(!terminationRequest);
+
+    svcKernelSetState(0x10007, 0);
+
+    Draw_Lock();
+    Draw_ClearFramebuffer();
+    Draw_FlushFramebuffer();
+    Draw_Unlock();
+}
+
 static inline void ProcessListMenu_HandleSelected(const ProcessInfo *info)
 {
     if(!gdbServer.super.running || info->isZombie)
@@ -699,6 +792,8 @@ void RosalinaMenu_ProcessList(void)
             break;
         else if(pressed & BUTTON_A)
             ProcessListMenu_HandleSelected(&infos[selected]);
+        else if(pressed & BUTTON_Y)
+            ProcessListMenu_IpcHotServices();
         else if(pressed & BUTTON_DOWN)
             selected++;
         else if(pressed & BUTTON_UP)
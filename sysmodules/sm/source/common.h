@@ -13,6 +13,8 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #define IS_PRE_7X (osGetFirmVersion() < SYSTEM_VERSION(2, 39, 4))
 #define IS_PRE_93 (osGetFirmVersion() < SYSTEM_VERSION(2, 48, 3))
 
+#define MAX_SESSIONS 76
+
 extern u32 nbSection0Modules;
 extern Handle resumeGetServiceHandleOrPortRegisteredSemaphore;
 
@@ -35,7 +37,7 @@ typedef struct SessionDataList
 } SessionDataList;
 
 extern SessionDataList sessionDataInUseList, freeSessionDataList;
-extern SessionDataList sessionDataWaitingForServiceOrPortRegisterList, sessionDataToWakeUpAfterServiceOrPortRegisterList;
+extern SessionDataList sessionDataToWakeUpAfterServiceOrPortRegisterList;
 extern SessionDataList sessionDataWaitingPortReadyList;
 
 static inline void panic(void)
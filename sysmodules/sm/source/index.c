@@ -0,0 +1,67 @@
+/*
+index.c
+
+(c) TuxSH, 2017
+This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for details).
+*/
+
+#include "index.h"
+
+static inline u32 hashKey(const Index *index, u64 key, u8 keyType)
+{
+    // Fibonacci hashing, keeping the top log2(size) bits
+    return (u32)(((key ^ keyType) * 0x9E3779B97F4A7C15ULL) >> (64 - __builtin_ctz(index->size)));
+}
+
+void initIndex(Index *index)
+{
+    for(u32 i = 0; i < index->size; i++)
+        index->entries[i].id = -1;
+}
+
+s32 findIndexSlot(const Index *index, u64 key, u8 keyType)
+{
+    u32 slot;
+    for(slot = hashKey(index, key, keyType); index->entries[slot].id != -1; slot = (slot + 1) & (index->size - 1))
+    {
+        if(index->entries[slot].key == key && index->entries[slot].keyType == keyType)
+            return (s32)slot;
+    }
+
+    return -1;
+}
+
+void insertIndexEntry(Index *index, u64 key, u8 keyType, s16 id)
+{
+    u32 slot;
+    for(slot = hashKey(index, key, keyType); index->entries[slot].id != -1; slot = (slot + 1) & (index->size - 1));
+
+    index->entries[slot].key = key;
+    index->entries[slot].keyType = keyType;
+    index->entries[slot].id = id;
+}
+
+void removeIndexEntry(Index *index, u32 slot)
+{
+    // Backward-shift deletion, no tombstones
+    IndexEntry *entries = index->entries;
+    u32 next = slot;
+    for(;;)
+    {
+        entries[slot].id = -1;
+        for(;;)
+        {
+            next = (next + 1) & (index->size - 1);
+            if(entries[next].id == -1)
+                return;
+
+            u32 home = hashKey(index, entries[next].key, entries[next].keyType);
+            // Move the entry back unless its home slot lies cyclically in (slot, next]
+            if(slot <= next ? (home <= slot || home > next) : (home <= slot && home > next))
+                break;
+        }
+
+        entries[slot] = entries[next];
+        slot = next;
+    }
+}
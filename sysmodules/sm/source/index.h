@@ -0,0 +1,30 @@
+/*
+index.h
+
+(c) TuxSH, 2017
+This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for details).
+*/
+
+#pragma once
+
+#include <3ds/types.h>
+
+// Open-addressing (linear probing) hash index from a key to the position of an element in some array.
+// keyType keeps apart keys from different spaces sharing an index, e.g. services and named ports
+typedef struct IndexEntry
+{
+    u64 key;
+    s16 id; // -1 if free
+    u8 keyType;
+} IndexEntry;
+
+typedef struct Index
+{
+    IndexEntry *entries;
+    u32 size; // Power of two. Users keep the index at most 3/4 full, so that probing stays short and always ends on a free slot
+} Index;
+
+void initIndex(Index *index);
+s32 findIndexSlot(const Index *index, u64 key, u8 keyType);
+void insertIndexEntry(Index *index, u64 key, u8 keyType, s16 id);
+void removeIndexEntry(Index *index, u32 slot);
@@ -12,19 +12,75 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #include "srv.h"
 #include "srv_pm.h"
 #include "list.h"
+#include "notifications.h"
 
 u32 nbSection0Modules;
 Handle resumeGetServiceHandleOrPortRegisteredSemaphore;
 
 SessionDataList sessionDataInUseList = {NULL, NULL}, freeSessionDataList = {NULL, NULL};
-SessionDataList sessionDataWaitingForServiceOrPortRegisterList = {NULL, NULL}, sessionDataToWakeUpAfterServiceOrPortRegisterList = {NULL, NULL};
+SessionDataList sessionDataToWakeUpAfterServiceOrPortRegisterList = {NULL, NULL};
 SessionDataList sessionDataWaitingPortReadyList = {NULL, NULL};
 
-static SessionData sessionDataPool[76];
-static ProcessData processDataPool[64];
+static SessionData sessionDataPool[MAX_SESSIONS];
 
 static u8 ALIGN(4) serviceAccessListStaticBuffer[0x110];
 
+// Layout: the semaphore, srv: and srv:pm ports; then nbSessions sessions; then the client ports of full services.
+// Entries are swap-removed, the parallel arrays below are moved along
+static Handle handles[0xE3];
+static SessionData *handleSessionData[0xE3]; // for sessions
+static u32 clientPortRefCounts[0xE3]; // for client ports: number of sessions waiting for them to be ready
+static u32 nbHandles = 3, nbSessions = 0;
+
+static u32 addSessionHandle(SessionData *sessionData)
+{
+    u32 id = 3 + nbSessions++;
+
+    // Move the first client port out of the way
+    handles[nbHandles] = handles[id];
+    clientPortRefCounts[nbHandles++] = clientPortRefCounts[id];
+
+    handles[id] = sessionData->handle;
+    handleSessionData[id] = sessionData;
+    return id;
+}
+
+static void removeSessionHandle(u32 id)
+{
+    u32 last = 3 + --nbSessions;
+    handles[id] = handles[last];
+    handleSessionData[id] = handleSessionData[last];
+
+    // Fill the hole with the last client port
+    handles[last] = handles[--nbHandles];
+    clientPortRefCounts[last] = clientPortRefCounts[nbHandles];
+}
+
+static void removeClientPortHandle(u32 id)
+{
+    handles[id] = handles[--nbHandles];
+    clientPortRefCounts[id] = clientPortRefCounts[nbHandles];
+}
+
+static void refClientPortHandle(Handle port)
+{
+    u32 id;
+    for(id = 3 + nbSessions; id < nbHandles && handles[id] != port; id++);
+    if(id >= nbHandles)
+    {
+        handles[nbHandles++] = port;
+        clientPortRefCounts[id] = 0;
+    }
+
+    ++clientPortRefCounts[id];
+}
+
+static void unrefClientPortHandle(u32 id)
+{
+    if(--clientPortRefCounts[id] == 0)
+        removeClientPortHandle(id);
+}
+
 void __appInit(void)
 {
     s64 out;
@@ -39,6 +95,8 @@ void __appInit(void)
 
     buildList(&freeSessionDataList, sessionDataPool, sizeof(sessionDataPool) / sizeof(SessionData), sizeof(SessionData));
     buildList(&freeProcessDataList, processDataPool, sizeof(processDataPool) / sizeof(ProcessData), sizeof(ProcessData));
+    initServices();
+    initNotifications();
 }
 
 
@@ -65,12 +123,12 @@ int main(void)
 {
     Result res;
     u32 *cmdbuf = getThreadCommandBuffer();
-    u32 nbHandles = 3, nbSessions = 0, nbSrvPmSessions = 0;
+    u32 nbSrvPmSessions = 0;
 
     Handle clientPortDummy;
     Handle srvPort, srvPmPort;
-    Handle handles[0xE3] = { 0 };
     Handle replyTarget = 0;
+    u32 replyTargetId = 0;
 
     u32 smPid;
     SessionData *sessionData;
@@ -99,52 +157,22 @@ int main(void)
             // Note: if a process has ended, pm will call UnregisterProcess on it
             if(id < 0)
             {
-                for(id = 3; (u32)id < nbHandles && handles[id] != replyTarget; id++);
-                if((u32)id >= nbHandles)
+                if(replyTarget == 0 || handles[replyTargetId] != replyTarget)
                     panic();
+                id = (s32)replyTargetId;
             }
 
             if(id < 3)
                 panic();
             else if((u32)id < 3 + nbSessions) // Session closed
             {
-                sessionData = NULL;
-                for(u32 i = 0; i < sizeof(sessionDataPool) / sizeof(SessionData); i++)
-                {
-                    if(sessionDataPool[i].handle == handles[id])
-                        sessionData = &sessionDataPool[i];
-                }
-
-                if(sessionData != NULL)
-                {
-                    if(sessionData->busyClientPortHandle != 0) // remove unreferenced client port handles from array
-                    {
-                        u32 refCount = 0;
-                        for(u32 i = 0; i < sizeof(sessionDataPool) / sizeof(SessionData); i++)
-                        {
-                            if(sessionDataPool[i].busyClientPortHandle == sessionData->busyClientPortHandle)
-                                ++refCount;
-                        }
-                        if(refCount <= 1)
-                        {
-                            u32 i;
-                            for(i = 3 + nbSessions; i < nbHandles && handles[i] == sessionData->busyClientPortHandle; i++);
-                            if(i < nbHandles)
-                                handles[i] = handles[--nbHandles];
-                        }
-                    }
-
-                    --nbHandles;
-                    for(u32 i = (u32)id; i < nbHandles; i++)
-                        handles[i] = handles[i + 1];
-                    --nbSessions;
-                    svcCloseHandle(sessionData->handle);
-                    if(sessionData->isSrvPm)
-                        --nbSrvPmSessions;
-                    moveNode(sessionData, &freeSessionDataList, false);
-                }
-                else
-                    panic();
+                // Sessions waiting for a client port aren't in the array, hence don't hold a reference to it
+                sessionData = handleSessionData[id];
+                removeSessionHandle((u32)id);
+                svcCloseHandle(sessionData->handle);
+                if(sessionData->isSrvPm)
+                    --nbSrvPmSessions;
+                moveNode(sessionData, &freeSessionDataList, false);
             }
             else // Port closed
             {
@@ -157,12 +185,13 @@ int main(void)
                     if(sessionData->busyClientPortHandle == handles[id])
                     {
                         sessionData->replayCmdbuf[1] = 0xD0406401; // unregistered service or named port
-                        moveNode(sessionData, &sessionDataWaitingForServiceOrPortRegisterList, true);
-                        svcCloseHandle(handles[id]);
-                        handles[id] = handles[--nbHandles];
+                        waitForServiceOrPortRegistration(sessionData);
                         sessionData->busyClientPortHandle = 0;
                     }
                 }
+
+                svcCloseHandle(handles[id]);
+                removeClientPortHandle((u32)id);
             }
 
             replyTarget = 0;
@@ -179,10 +208,7 @@ int main(void)
                 sessionData = (SessionData *)allocateNode(&sessionDataInUseList, &freeSessionDataList, sizeof(SessionData), false);
                 sessionData->pid = (u32)-1;
                 sessionData->handle = session;
-                for(u32 i = nbHandles; i > 3 + nbSessions; i--)
-                    handles[i] = handles[i - 1];
-                handles[3 + nbSessions++] = session;
-                ++nbHandles;
+                addSessionHandle(sessionData);
             }
             else if(id == 2) // New srv:pm session
             {
@@ -194,10 +220,7 @@ int main(void)
                 sessionData->pid = (u32)-1;
                 sessionData->handle = session;
                 sessionData->isSrvPm = true;
-                for(u32 i = nbHandles; i > 3 + nbSessions; i--)
-                    handles[i] = handles[i - 1];
-                handles[3 + nbSessions++] = session;
-                ++nbHandles;
+                addSessionHandle(sessionData);
                 ++nbSrvPmSessions;
             }
             else
@@ -208,73 +231,54 @@ int main(void)
                         panic();
                     sessionData = sessionDataToWakeUpAfterServiceOrPortRegisterList.first;
                     moveNode(sessionData, &sessionDataInUseList, false);
-                    for(u32 i = nbHandles; i > 3 + nbSessions; i--)
-                        handles[i] = handles[i - 1];
-                    handles[3 + nbSessions++] = sessionData->handle;
-                    ++nbHandles;
+                    id = (s32)addSessionHandle(sessionData);
                     if(sessionData->isSrvPm)
                         ++nbSrvPmSessions;
                     memcpy(cmdbuf, sessionData->replayCmdbuf, 16);
                 }
                 else if((u32)id >= 3 + nbSessions) // Resume SRV:GetServiceHandle if service was full
                 {
-                    SessionData *sTmp;
                     for(sessionData = sessionDataWaitingPortReadyList.first; sessionData != NULL && sessionData->busyClientPortHandle != handles[id];
                         sessionData = sessionData->next);
                     if(sessionData == NULL)
                         panic();
                     moveNode(sessionData, &sessionDataInUseList, false);
-                    for(sTmp = sessionDataWaitingPortReadyList.first; sTmp != NULL && sTmp->busyClientPortHandle != handles[id]; sTmp = sTmp->next);
-                    if(sTmp == NULL)
-                        handles[id] = handles[--nbHandles];
-                    for(u32 i = nbHandles + 1; i > 3 + nbSessions; i--)
-                        handles[i] = handles[i - 1];
-                    handles[3 + nbSessions++] = sessionData->handle;
-                    ++nbHandles;
+                    unrefClientPortHandle((u32)id);
+                    id = (s32)addSessionHandle(sessionData);
                     if(sessionData->isSrvPm)
                         ++nbSrvPmSessions;
                     memcpy(cmdbuf, sessionData->replayCmdbuf, 16);
                     sessionData->busyClientPortHandle = 0;
                 }
                 else
-                {
-                    for(sessionData = sessionDataInUseList.first; sessionData != NULL && sessionData->handle != handles[id]; sessionData = sessionData->next);
-                    if(sessionData == NULL)
-                        panic();
-                }
-
-                for(id = 3; (u32)id < 3 + nbSessions && handles[id] != sessionData->handle; id++);
-                if((u32)id >= 3 + nbSessions)
-                    panic();
+                    sessionData = handleSessionData[id];
 
                 res = sessionData->isSrvPm ? srvPmHandleCommands(sessionData) : srvHandleCommands(sessionData);
 
                 if(R_MODULE(res) == RM_SRV && R_SUMMARY(res) == RS_WOULDBLOCK)
                 {
-                    SessionDataList *dstList = NULL;
-                    if(res == (Result)0xD0406401) // service or named port not registered yet
-                        dstList = &sessionDataWaitingForServiceOrPortRegisterList;
-                    else if(res == (Result)0xD0406402) // service full
+                    SessionDataList *dstList = NULL; // NULL: wait for the service or named port to be registered
+                    if(res == (Result)0xD0406402) // service full
                     {
-                        u32 i;
                         dstList = &sessionDataWaitingPortReadyList;
-                        for(i = 3 + nbSessions; i < nbHandles && handles[i] != sessionData->busyClientPortHandle; i++);
-                        if(i >= nbHandles)
-                            handles[nbHandles++] = sessionData->busyClientPortHandle;
+                        refClientPortHandle(sessionData->busyClientPortHandle);
                     }
-                    else
+                    else if(res != (Result)0xD0406401) // service or named port not registered yet
                         panic();
 
-                    --nbHandles;
-                    for(u32 i = (u32)id; i < nbHandles; i++)
-                        handles[i] = handles[i + 1];
-                    --nbSessions;
+                    removeSessionHandle((u32)id);
                     if(sessionData->isSrvPm)
                         --nbSrvPmSessions;
-                    moveNode(sessionData, dstList, true);
+                    if(dstList == NULL)
+                        waitForServiceOrPortRegistration(sessionData);
+                    else
+                        moveNode(sessionData, dstList, true);
                 }
                 else
+                {
                     replyTarget = sessionData->handle;
+                    replyTargetId = (u32)id;
+                }
             }
         }
     }
@@ -7,14 +7,83 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 
 #include "notifications.h"
 #include "processes.h"
+#include "index.h"
+
+#define NOTIFICATION_INDEX_SIZE 0x200
+
+// Subscribers of each notification ID that has some, as a bitset of processDataPool slots
+typedef struct NotificationSubscribers
+{
+    u32 notificationId;
+    u64 subscribers;
+} NotificationSubscribers;
+
+static NotificationSubscribers notificationsSubscribers[3 * NOTIFICATION_INDEX_SIZE / 4];
+static u32 nbSubscribedNotifications = 0;
+
+// Position in notificationsSubscribers of each notification ID
+static IndexEntry notificationsIndexEntries[NOTIFICATION_INDEX_SIZE];
+static Index notificationsIndex = { notificationsIndexEntries, NOTIFICATION_INDEX_SIZE };
+
+static inline u32 pendingNotificationBit(u32 notificationId)
+{
+    return 1u << ((notificationId * 0x9E3779B1) >> 27);
+}
+
+static inline u64 processDataBit(const ProcessData *processData)
+{
+    return 1ULL << (processData - processDataPool);
+}
+
+static NotificationSubscribers *findNotificationSubscribers(u32 notificationId)
+{
+    s32 slot = findIndexSlot(&notificationsIndex, notificationId, 0);
+    return slot == -1 ? NULL : &notificationsSubscribers[notificationsIndex.entries[slot].id];
+}
+
+static NotificationSubscribers *addNotificationSubscribers(u32 notificationId)
+{
+    if(nbSubscribedNotifications >= sizeof(notificationsSubscribers) / sizeof(NotificationSubscribers))
+        return NULL;
+
+    NotificationSubscribers *entry = &notificationsSubscribers[nbSubscribedNotifications];
+    entry->notificationId = notificationId;
+    entry->subscribers = 0;
+    insertIndexEntry(&notificationsIndex, notificationId, 0, (s16)nbSubscribedNotifications++);
+
+    return entry;
+}
+
+static void removeSubscriber(NotificationSubscribers *entry, const ProcessData *processData)
+{
+    entry->subscribers &= ~processDataBit(processData);
+    if(entry->subscribers != 0)
+        return;
+
+    removeIndexEntry(&notificationsIndex, (u32)findIndexSlot(&notificationsIndex, entry->notificationId, 0));
+
+    u32 id = entry - notificationsSubscribers;
+    if(id != --nbSubscribedNotifications)
+    {
+        // Move the last entry in the freed spot
+        NotificationSubscribers *last = &notificationsSubscribers[nbSubscribedNotifications];
+        notificationsIndex.entries[findIndexSlot(&notificationsIndex, last->notificationId, 0)].id = (s16)id;
+        *entry = *last;
+    }
+}
+
+void initNotifications(void)
+{
+    initIndex(&notificationsIndex);
+}
 
 static bool doPublishNotification(ProcessData *processData, u32 notificationId, u32 flags)
 {
-    if((flags & 1) && processData->nbPendingNotifications != 0) // only send if not already pending
+    if((flags & 1) && (processData->pendingNotificationsFilter & pendingNotificationBit(notificationId))) // only send if not already pending
     {
         for(u16 i = 0; i < processData->nbPendingNotifications; i++)
         {
-            if(processData->pendingNotifications[(processData->pendingNotificationIndex + i) % 16] == notificationId)
+            if(processData->pendingNotifications[(processData->receivedNotificationIndex + i) % 16] == notificationId)
                 return true;
         }
     }
@@ -26,6 +95,7 @@ static bool doPublishNotification(ProcessData *processData, u32 notificationId,
         processData->pendingNotifications[processData->pendingNotificationIndex] = notificationId;
         processData->pendingNotificationIndex = (processData->pendingNotificationIndex + 1) % 16;
         ++processData->nbPendingNotifications;
+        processData->pendingNotificationsFilter |= pendingNotificationBit(notificationId);
         assertSuccess(svcReleaseSemaphore(&count, processData->notificationSemaphore, 1));
 
         return true;
@@ -61,14 +131,16 @@ Result Subscribe(SessionData *sessionData, u32 notificationId)
     if(processData == NULL || !processData->notificationEnabled)
         return 0xD8806404;
 
-    for(u16 i = 0; i < processData->nbSubscribed; i++)
-    {
-        if(processData->subscribedNotifications[i] == notificationId)
-            return 0xD9006403;
-    }
+    NotificationSubscribers *entry = findNotificationSubscribers(notificationId);
+    if(entry != NULL && (entry->subscribers & processDataBit(processData)) != 0)
+        return 0xD9006403;
 
     if(processData->nbSubscribed < 0x11)
     {
+        if(entry == NULL && (entry = addNotificationSubscribers(notificationId)) == NULL)
+            return 0xD9006405;
+
+        entry->subscribers |= processDataBit(processData);
         processData->subscribedNotifications[processData->nbSubscribed++] = notificationId;
         return 0;
     }
@@ -76,6 +148,14 @@ Result Subscribe(SessionData *sessionData, u32 notificationId)
         return 0xD9006405;
 }
 
+void doUnsubscribeAll(ProcessData *processData)
+{
+    for(u16 i = 0; i < processData->nbSubscribed; i++)
+        removeSubscriber(findNotificationSubscribers(processData->subscribedNotifications[i]), processData);
+
+    processData->nbSubscribed = 0;
+}
+
 Result Unsubscribe(SessionData *sessionData, u32 notificationId)
 {
     ProcessData *processData = findProcessData(sessionData->pid);
@@ -90,6 +170,7 @@ Result Unsubscribe(SessionData *sessionData, u32 notificationId)
         return 0xD8806404;
     else
     {
+        removeSubscriber(findNotificationSubscribers(notificationId), processData);
         processData->subscribedNotifications[i] = processData->subscribedNotifications[--processData->nbSubscribed];
         return 0;
     }
@@ -110,41 +191,32 @@ Result ReceiveNotification(SessionData *sessionData, u32 *notificationId)
         --processData->nbPendingNotifications;
         *notificationId = processData->pendingNotifications[processData->receivedNotificationIndex];
         processData->receivedNotificationIndex = (processData->receivedNotificationIndex + 1) % 16;
+
+        u32 filter = 0;
+        for(u16 i = 0; i < processData->nbPendingNotifications; i++)
+            filter |= pendingNotificationBit(processData->pendingNotifications[(processData->receivedNotificationIndex + i) % 16]);
+        processData->pendingNotificationsFilter = filter;
+
         return 0;
     }
 }
 
 Result PublishToSubscriber(u32 notificationId, u32 flags)
 {
-    for(ProcessData *node = processDataInUseList.first; node != NULL; node = node->next)
-    {
-        if(!node->notificationEnabled)
-            continue;
-
-        u16 i;
-        for(i = 0; i < node->nbSubscribed && node->subscribedNotifications[i] != notificationId; i++);
-        if(i >= node->nbSubscribed)
-            continue;
-
-        if(!doPublishNotification(node, notificationId, flags))
-            return 0xD8606408;
-    }
-
-    return 0;
+    return PublishAndGetSubscriber(NULL, NULL, notificationId, flags);
 }
 
 Result PublishAndGetSubscriber(u32 *pidCount, u32 *pidList, u32 notificationId, u32 flags)
 {
+    NotificationSubscribers *entry = findNotificationSubscribers(notificationId);
+    u64 subscribers = entry != NULL ? entry->subscribers : 0;
     u32 nb = 0;
-    for(ProcessData *node = processDataInUseList.first; node != NULL; node = node->next)
-    {
-        if(!node->notificationEnabled)
-            continue;
 
-        u16 i;
-        for(i = 0; i < node->nbSubscribed && node->subscribedNotifications[i] != notificationId; i++);
-        if(i >= node->nbSubscribed)
-            continue;
+    // Only processes with notifications enabled can subscribe
+    while(subscribers != 0)
+    {
+        ProcessData *node = &processDataPool[__builtin_ctzll(subscribers)];
+        subscribers &= subscribers - 1;
 
         if(!doPublishNotification(node, notificationId, flags))
             return 0xD8606408;
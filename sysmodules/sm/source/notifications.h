@@ -8,8 +8,11 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #pragma once
 
 #include "common.h"
+#include "processes.h"
 
+void initNotifications(void);
 Result EnableNotification(SessionData *sessionData, Handle *notificationSemaphore);
+void doUnsubscribeAll(ProcessData *processData);
 Result Subscribe(SessionData *sessionData, u32 notificationId);
 Result Unsubscribe(SessionData *sessionData, u32 notificationId);
 Result ReceiveNotification(SessionData *sessionData, u32 *notificationId);
@@ -8,8 +8,10 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #include "list.h"
 #include "processes.h"
 #include "services.h"
+#include "notifications.h"
 
 ProcessDataList processDataInUseList = { NULL, NULL }, freeProcessDataList = { NULL, NULL };
+ProcessData processDataPool[64];
 
 ProcessData *findProcessData(u32 pid)
 {
@@ -58,17 +60,8 @@ Result UnregisterProcess(u32 pid)
     svcCloseHandle(processData->notificationSemaphore);
 
     // Unregister the services registered by the process
-    u32 i = 0;
-    while(i < nbServices)
-    {
-        if(servicesInfo[i].pid == pid)
-        {
-            svcCloseHandle(servicesInfo[i].clientPort);
-            servicesInfo[i] = servicesInfo[--nbServices];
-        }
-        else
-            ++i;
-    }
+    doUnregisterServicesOfProcess(pid);
+    doUnsubscribeAll(processData);
 
     moveNode(processData, &freeProcessDataList, false);
     return 0;
@@ -30,6 +30,7 @@ typedef struct ProcessData
 
     u16 nbPendingNotifications;
     u32 pendingNotifications[16];
+    u32 pendingNotificationsFilter; // one bit per hash of the pending notification IDs
     u16 nbSubscribed;
     u32 subscribedNotifications[17];
 } ProcessData;
@@ -40,6 +41,7 @@ typedef struct ProcessDataList
 } ProcessDataList;
 
 extern ProcessDataList processDataInUseList, freeProcessDataList;
+extern ProcessData processDataPool[64];
 
 ProcessData *findProcessData(u32 pid);
 ProcessData *doRegisterProcess(u32 pid, char (*serviceAccessList)[8], u32 serviceAccessListSize);
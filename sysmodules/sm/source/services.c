@@ -9,10 +9,27 @@ This is part of 3ds_sm, which is licensed under the MIT license (see LICENSE for
 #include "processes.h"
 #include "memory.h"
 #include "list.h"
+#include "index.h"
 
 ServiceInfo servicesInfo[0xA0] = { 0 };
 u32 nbServices = 0; // including "ports" registered with getPort
 
+// Indices keyed by the service name packed into a u64, with the named port flag as key type
+#define SERVICE_INDEX_SIZE 0x100
+
+// Sessions waiting for a given service or named port to be registered
+typedef struct ServiceWaitList
+{
+    u64 name;
+    bool isNamedPort;
+    SessionDataList sessions;
+} ServiceWaitList;
+
+static IndexEntry servicesIndexEntries[SERVICE_INDEX_SIZE], serviceWaitListsIndexEntries[SERVICE_INDEX_SIZE];
+static Index servicesIndex = { servicesIndexEntries, SERVICE_INDEX_SIZE };
+static Index serviceWaitListsIndex = { serviceWaitListsIndexEntries, SERVICE_INDEX_SIZE };
+static ServiceWaitList serviceWaitLists[MAX_SESSIONS];
+
 static Result checkServiceName(const char *name, s32 nameSize)
 {
     if(nameSize <= 0 || nameSize > 8)
@@ -23,17 +40,86 @@ static Result checkServiceName(const char *name, s32 nameSize)
         return 0;
 }
 
-static inline bool areServiceNamesEqual(const char *name, const char *name2, s32 nameSize)
+static inline u64 packServiceName(const char *name, s32 nameSize)
 {
-    return strncmp(name, name2, nameSize) == 0 && (nameSize == 8 || name[nameSize] == 0);
+    // Names are checked not to contain NUL characters, the remaining bytes are zero
+    u64 packed = 0;
+    for(s32 i = 0; i < nameSize && i < 8; i++)
+        packed |= (u64)(u8)name[i] << (8 * i);
+
+    return packed;
 }
 
 static s32 findServicePortByName(bool isNamedPort, const char *name, s32 nameSize)
 {
-    ServiceInfo *info;
-    for(info = servicesInfo; info < servicesInfo + nbServices && (info->isNamedPort != isNamedPort || !areServiceNamesEqual(info->name, name, nameSize)); info++);
+    s32 slot = findIndexSlot(&servicesIndex, packServiceName(name, nameSize), isNamedPort);
+    return slot == -1 ? -1 : servicesIndex.entries[slot].id;
+}
+
+static void removeServiceInfo(s32 serviceId)
+{
+    ServiceInfo *info = &servicesInfo[serviceId];
+    u64 name = packServiceName(info->name, 8);
+    removeIndexEntry(&servicesIndex, (u32)findIndexSlot(&servicesIndex, name, info->isNamedPort));
+
+    svcCloseHandle(info->clientPort);
+
+    if((u32)serviceId != --nbServices)
+    {
+        // Move the last entry in the freed spot
+        ServiceInfo *last = &servicesInfo[nbServices];
+        s32 slot = findIndexSlot(&servicesIndex, packServiceName(last->name, 8), last->isNamedPort);
+        servicesIndex.entries[slot].id = (s16)serviceId;
+        *info = *last;
+    }
+}
+
+void initServices(void)
+{
+    initIndex(&servicesIndex);
+    initIndex(&serviceWaitListsIndex);
+}
+
+void waitForServiceOrPortRegistration(SessionData *sessionData)
+{
+    bool isNamedPort = (sessionData->replayCmdbuf[0] & 0xF0000) == 0x80000;
+    u64 name = packServiceName((const char *)(sessionData->replayCmdbuf + 1), (s32)sessionData->replayCmdbuf[3]);
+    s32 slot = findIndexSlot(&serviceWaitListsIndex, name, isNamedPort);
+    ServiceWaitList *waitList;
+
+    if(slot != -1)
+        waitList = &serviceWaitLists[serviceWaitListsIndex.entries[slot].id];
+    else
+    {
+        // There can't be more lists than sessions, so a free one is always found
+        for(waitList = serviceWaitLists; waitList->sessions.first != NULL; waitList++);
+
+        waitList->name = name;
+        waitList->isNamedPort = isNamedPort;
+        insertIndexEntry(&serviceWaitListsIndex, name, isNamedPort, (s16)(waitList - serviceWaitLists));
+    }
+
+    moveNode(sessionData, &waitList->sessions, true);
+}
+
+static s32 wakeUpSessionsWaitingForServiceOrPort(u64 name, bool isNamedPort)
+{
+    s32 slot = findIndexSlot(&serviceWaitListsIndex, name, isNamedPort);
+    s32 n = 0;
+
+    if(slot == -1)
+        return 0;
+
+    ServiceWaitList *waitList = &serviceWaitLists[serviceWaitListsIndex.entries[slot].id];
+    while(waitList->sessions.first != NULL)
+    {
+        moveNode(waitList->sessions.first, &sessionDataToWakeUpAfterServiceOrPortRegisterList, true);
+        ++n;
+    }
+
+    removeIndexEntry(&serviceWaitListsIndex, (u32)slot);
 
-    return info >= servicesInfo + nbServices ? -1 : info - servicesInfo;
+    return n;
 }
 
 static bool checkServiceAccess(SessionData *sessionData, const char *name, s32 nameSize)
@@ -67,26 +153,16 @@ static Result doRegisterServiceOrPort(u32 pid, Handle *serverPort, Handle client
     else
         portClient = clientPort;
 
-    ServiceInfo *serviceInfo = &servicesInfo[nbServices++];
-    strncpy(serviceInfo->name, name, 8);
+    u64 packedName = packServiceName(name, nameSize);
+    ServiceInfo *serviceInfo = &servicesInfo[nbServices];
+    memcpy(serviceInfo->name, &packedName, 8);
 
     serviceInfo->pid = pid;
     serviceInfo->clientPort = portClient;
     serviceInfo->isNamedPort = isNamedPort;
+    insertIndexEntry(&servicesIndex, packedName, isNamedPort, (s16)nbServices++);
 
-    SessionData *nextSessionData;
-    s32 n = 0;
-
-    for(SessionData *node = sessionDataWaitingForServiceOrPortRegisterList.first; node != NULL; node = nextSessionData)
-    {
-        nextSessionData = node->next;
-        if((node->replayCmdbuf[0] & 0xF0000) == (!isNamedPort ? 0x50000 : 0x80000) &&
-            areServiceNamesEqual((const char *)(node->replayCmdbuf + 1), name, (s32)node->replayCmdbuf[3]))
-        {
-            moveNode(node, &sessionDataToWakeUpAfterServiceOrPortRegisterList, true);
-            ++n;
-        }
-    }
+    s32 n = wakeUpSessionsWaitingForServiceOrPort(packedName, isNamedPort);
     if(n > 0)
     {
         s32 count;
@@ -129,13 +205,23 @@ static Result UnregisterServiceOrPort(SessionData *sessionData, const char *name
         return 0xD8E06406;
     else
     {
-        svcCloseHandle(servicesInfo[serviceId].clientPort);
-
-        servicesInfo[serviceId] = servicesInfo[--nbServices];
+        removeServiceInfo(serviceId);
         return 0;
     }
 }
 
+void doUnregisterServicesOfProcess(u32 pid)
+{
+    u32 i = 0;
+    while(i < nbServices)
+    {
+        if(servicesInfo[i].pid == pid)
+            removeServiceInfo((s32)i);
+        else
+            ++i;
+    }
+}
+
 Result UnregisterService(SessionData *sessionData, const char *name, s32 nameSize)
 {
     return UnregisterServiceOrPort(sessionData, name, nameSize, false);
@@ -22,7 +22,11 @@ typedef struct ServiceInfo
 extern ServiceInfo servicesInfo[0xA0];
 extern u32 nbServices;
 
+void initServices(void);
+void waitForServiceOrPortRegistration(SessionData *sessionData);
+
 Result doRegisterService(u32 pid, Handle *serverPort, const char *name, s32 nameSize, s32 maxSessions);
+void doUnregisterServicesOfProcess(u32 pid);
 Result RegisterService(SessionData *sessionData, Handle *serverPort, const char *name, s32 nameSize, s32 maxSessions);
 Result RegisterPort(SessionData *sessionData, Handle clientPort, const char *name, s32 nameSize);
 Result UnregisterService(SessionData *sessionData, const char *name, s32 nameSize);